@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+#include "LibInternal.h"
+
+SOFTX_BEGIN
+
+//     
+enum class IndexFormat
+{
+	UInt16, // 2 ,   0xFFFF
+	UInt32	// 4 ,   0xFFFFFFFF
+};
+
+//     
+enum class BufferUsage
+{
+	Immutable, //     
+	Default,   //    Update
+	Dynamic	   //    CPU  Device::Map
+};
+
+//  Device::Map  Dynamic-
+enum class MapMode
+{
+	WriteDiscard,	 //   ;      draw
+	WriteNoOverwrite //    ;      
+};
+
+//      ( )
+enum BufferBindFlags : uint32_t
+{
+	BIND_VERTEX_BUFFER = 1 << 0,
+	BIND_INDEX_BUFFER = 1 << 1,
+	BIND_CONSTANT_BUFFER = 1 << 2,
+	BIND_INDIRECT_ARGS = 1 << 3 //  DrawIndexedIndirectArgs  Device::DrawIndexedIndirect
+};
+
+struct BufferDesc
+{
+	size_t ByteWidth;	//   
+	BufferUsage Usage;	//  
+	uint32_t BindFlags; //  BufferBindFlags
+
+	BufferDesc() : ByteWidth(0), Usage(BufferUsage::Default), BindFlags(0)
+	{
+	}
+	BufferDesc(size_t byteWidth, BufferUsage usage, uint32_t bindFlags)
+		: ByteWidth(byteWidth), Usage(usage), BindFlags(bindFlags)
+	{
+	}
+};
+
+// -   :        
+//   BufferPtr,      
+class SOFTX_API Buffer
+{
+  public:
+	Buffer(const BufferDesc& desc, const void* initialData)
+		: m_desc(desc), m_data(desc.ByteWidth), m_version(nullptr), m_versionFrame(0), m_tracked(false), m_mapped(false)
+	{
+		if (initialData)
+			std::memcpy(m_data.data(), initialData, desc.ByteWidth);
+	}
+
+	//    (  Default, Dynamic   Device::Map).
+	//  false,         
+	bool Update(const void* data, size_t offset, size_t size)
+	{
+		if (m_desc.Usage != BufferUsage::Default)
+			return false;
+		if (offset + size > m_data.size())
+			return false;
+		std::memcpy(m_data.data() + offset, data, size);
+		return true;
+	}
+
+	const BufferDesc& GetDesc() const
+	{
+		return m_desc;
+	}
+	size_t Size() const
+	{
+		return m_data.size();
+	}
+	//    ( Dynamic  Map(WriteDiscard) -    )
+	const uint8_t* Data() const
+	{
+		return m_version ? m_version : m_data.data();
+	}
+	bool IsMapped() const
+	{
+		return m_mapped;
+	}
+
+  private:
+	friend class Device;
+	friend class VertexBuffer;
+	friend class IndexBuffer;
+
+	BufferDesc m_desc;
+	std::vector<uint8_t> m_data; //  
+
+	uint8_t* m_version;		 //   RingAllocator   nullptr
+	uint64_t m_versionFrame; // ,    m_version
+	bool m_tracked;			 //         m_data
+	bool m_mapped;
+};
+
+using BufferPtr = std::shared_ptr<Buffer>;
+
+//   :  +    + 
+struct VertexBufferView
+{
+	BufferPtr Buffer;
+	uint32_t Offset; //  
+	uint32_t Stride; //    
+
+	VertexBufferView() : Buffer(nullptr), Offset(0), Stride(0)
+	{
+	}
+	VertexBufferView(const BufferPtr& buffer, uint32_t stride, uint32_t offset = 0)
+		: Buffer(buffer), Offset(offset), Stride(stride)
+	{
+	}
+
+	const uint8_t* Data() const
+	{
+		return Buffer->Data() + Offset;
+	}
+	size_t VertexCount() const
+	{
+		//     -  ,     
+		return (Buffer && Stride && Offset < Buffer->Size()) ? (Buffer->Size() - Offset) / Stride : 0;
+	}
+	bool IsEmpty() const
+	{
+		return VertexCount() == 0;
+	}
+};
+
+//   
+struct IndexBufferView
+{
+	BufferPtr Buffer;
+	uint32_t Offset; //  
+	IndexFormat Format;
+
+	IndexBufferView() : Buffer(nullptr), Offset(0), Format(IndexFormat::UInt32)
+	{
+	}
+	IndexBufferView(const BufferPtr& buffer, IndexFormat format = IndexFormat::UInt32, uint32_t offset = 0)
+		: Buffer(buffer), Offset(offset), Format(format)
+	{
+	}
+
+	uint32_t IndexSize() const
+	{
+		return Format == IndexFormat::UInt16 ? 2 : 4;
+	}
+	// ,  strip/fan    
+	uint32_t RestartIndex() const
+	{
+		return Format == IndexFormat::UInt16 ? 0xFFFFu : 0xFFFFFFFFu;
+	}
+	const uint8_t* Data() const
+	{
+		return Buffer->Data() + Offset;
+	}
+	size_t IndexCount() const
+	{
+		return (Buffer && Offset < Buffer->Size()) ? (Buffer->Size() - Offset) / IndexSize() : 0;
+	}
+	bool IsEmpty() const
+	{
+		return IndexCount() == 0;
+	}
+};
+
+SOFTX_END
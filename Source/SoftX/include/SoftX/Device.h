@@ -5,20 +5,46 @@
 
 #include "LibInternal.h"
 #include "ThreadPool.h"
+#include "RingAllocator.h"
 #include "DeviceContext.h"
+#include "Meshlet.h"
+#include "Texture.h"
+#include "MultisampleFramebuffer.h"
 
 SOFTX_BEGIN
 
 class SOFTX_API Device {
 public:
     Device(const PresentParameters& params);
-    ~Device() = default;
+    ~Device();
 
 	void SetDeviceContext(const DeviceContext& ctx);
 	DeviceContext GetDeviceContext() const;
 
+	//  -. Immutable-   .
+	//  nullptr,   
+	BufferPtr CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr);
+
+	//   Dynamic-  CPU. WriteDiscard      ,
+	// WriteNoOverwrite  .     - nullptr
+	void* Map(const BufferPtr& buffer, MapMode mode);
+	void Unmap(const BufferPtr& buffer);
+
+	//     ;  ,    
+	ConstantBuffer UploadConstantBuffer(const void* data, size_t size);
+
+	//  -     
+	void GenerateMips(TextureRGBA32F& texture, MipFilter filter = MipFilter::Box);
+
+	//       ( ),
+	//   DeviceContext::GetTileSize     
+	void ResolveMultisample(const MultisampleFramebuffer& source, IRenderTarget& dest);
+
 	void SetVertexBuffer(const VertexBuffer& buffer);
+	void SetVertexBuffer(const VertexBufferView& view);
 	void SetIndexBuffer(const IndexBuffer& buffer);
+	void SetIndexBuffer(const IndexBufferView& view);
+	void SetInstanceBuffer(const VertexBufferView& view);
 	void SetConstantBuffer(ConstantBuffer cbuffer);
 
     //    
@@ -29,12 +55,43 @@ public:
 	void DrawFullScreenQuad();
     void DrawIndexed(uint32_t indexCount, uint32_t startIndex);
     void DrawIndexed();
+	//  instanceCount       .
+	//    baseVertex,  PerInstance    
+	//   startInstance, VertexAttributes::InstanceID()   .
+	//       
+	void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex = 0,
+							  int32_t baseVertex = 0, uint32_t startInstance = 0);
+	//      (BIND_INDIRECT_ARGS),  DrawIndexedIndirectArgs   stride.
+	//     :    , 
+	//      
+	void DrawIndexedIndirect(const BufferPtr& args, uint32_t offset);
+	// bounds ( ) -    ,  
+	void MultiDrawIndexedIndirect(const BufferPtr& args, uint32_t offset, uint32_t drawCount,
+								  uint32_t stride = sizeof(DrawIndexedIndirectArgs), const DrawBounds* bounds = nullptr);
+	//    ;  -    ,    .
+	//      (cullFlags)    :
+	// world -    ,  - DeviceContext::SetViewProjection.
+	// MESHLET_CULL_OCCLUSION      (  )
+	void DrawMeshlets(const MeshletMesh& mesh, const float4x4& world = float4x4(),
+					  uint32_t cullFlags = MESHLET_CULL_FRUSTUM | MESHLET_CULL_BACKFACE);
+
+	//  .      :
+	//        BeginQuery  EndQuery
+	void BeginQuery(OcclusionQuery& query);
+	void EndQuery(OcclusionQuery& query);
 
-    float4 ClipToScreen(const float4& clipPos) const;
+	//     ResetStatistics
+	const PipelineStatistics& GetStatistics() const;
+	void ResetStatistics();
+
+    float4 ClipToScreen(const float4& clipPos, uint32_t viewport = 0) const;
+    //      ,   
     void DrawPoint(int x, int y, float z, const float4& color);
 	void DrawLine(int x0, int y0, int x1, int y1, float z0, float z1, const float4& color);
-	void RasterizeTriangle(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2);
-	void RasterizeTriangleSSE(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2);
+	//    m_transformedVerts (tri -  )
+	void RasterizeTriangle(const int3& tri);
+	//    ( MSAA - ),   
+	uint64_t RasterizeTriangleSSE(const int3& tri);
 
     // :     
     void Present();
@@ -56,19 +113,152 @@ private:
 	bool m_tiledRendering;
 	int m_tileSize;
 	std::vector<Tile> m_tiles;
-	std::vector<VertexOutput> m_transformedVerts;
+	int2 m_tileGridMin, m_tileGridMax; //  m_tiles     ()
+	std::vector<uint8_t> m_smallTriangles; //   ,   
+	static constexpr int SMALL_TRIANGLE_BLOCK = 8;
+	TransformedVertices m_transformedVerts;
 	std::vector<int3> m_triangles;
+	std::vector<uint32_t> m_indices; //  16- 
+	std::vector<uint32_t> m_usedVertices; //      
+	std::vector<uint32_t> m_vertexSlots;  //    ->    (~0u -  )
+	std::vector<int3> m_instanceTriangles; //      m_usedVertices 
+	std::vector<DrawIndexedIndirectArgs> m_indirectArgs;
+
+	//  :      
+	struct PreparedDraw
+	{
+		uint32_t FirstVertex, VertexCount;     //  m_usedVertices
+		uint32_t FirstTriangle, TriangleCount; //  m_instanceTriangles
+		uint32_t InstanceCount, StartInstance;
+	};
+	//  :  [FirstInstance, FirstInstance + InstanceCount)  Draw,
+	//     m_transformedVerts   FirstTransformed
+	struct BatchItem
+	{
+		uint32_t Draw, FirstInstance, InstanceCount, FirstTransformed;
+	};
+	std::vector<PreparedDraw> m_preparedDraws;
+	std::vector<BatchItem> m_batch;
+
+	//          
+	static constexpr uint32_t MAX_BATCH_VERTICES = 1 << 20;
+	static constexpr uint32_t PARALLEL_VERTEX_THRESHOLD = 4096;
+	//        
+	static constexpr uint32_t PARALLEL_MESHLET_THRESHOLD = 256;
+
+	//     (      draw)
+	VertexProgram m_vertexProgram;
+	InputLayout m_inputLayout;
+	QuadPixelProgram m_pixelProgram;
+	uint32_t m_varyingCount;
+	//    (   )    .
+	// m_depthOnly -   ,   :   
+	DepthBuffer* m_depthTarget;
+	DepthFunc m_depthFunc = DepthFunc::Less;
+	bool m_depthWrite = true;
+	int2 m_targetSize;
+	bool m_depthOnly = false;
+	//     i   (): , 
+	//    . m_clipTriangles -      
+	uint32_t m_viewportCount = 1;
+	int2 m_clipMin[MAX_VIEWPORTS];
+	int2 m_clipMax[MAX_VIEWPORTS];
+	bool m_clipTriangles = false;
+	void setupClipRects();
+	uint32_t triangleViewport(const int3& tri) const
+	{
+		return m_viewportCount > 1 ? m_transformedVerts.ViewportIndex[tri.x] : 0;
+	}
+	//       
+	void clipToViewport(uint32_t viewport, int2& rectMin, int2& rectMax) const;
+	//      [clipMin, clipMax] ( )
+	void drawLine(int x0, int y0, int x1, int y1, float z0, float z1, const float4& color, int2 clipMin,
+				  int2 clipMax);
+	//    SoA ( -  dest); nullptr -    
+	using BlendFunction = void (*)(const BlendState& state, const __m128 src[4], __m128 dest[4]);
+	BlendState m_blendState;
+	BlendFunction m_blendFunction = nullptr;
+	IRenderTarget* m_renderTargets[MAX_RENDER_TARGETS] = {};
+	uint32_t m_renderTargetCount = 0;
+	//      .  MSAA    
+	//  m_sampleDepth (MSAA_SAMPLE_COUNT   ), m_depthTarget  
+	uint32_t m_sampleCount = 1;
+	std::vector<float> m_sampleDepth;
+	float m_depthClearValue = 1.0f;
 	std::unique_ptr<ThreadPool> m_threadPool;
 
-	//    
-	void buildTiles(int width, int height);
-	void binTriangles(const std::vector<VertexOutput>& transformedVerts, const std::vector<int3>& triangles);
+	//   Dynamic-  ,    
+	RingAllocator m_uploadRing;
+	std::vector<std::weak_ptr<Buffer>> m_dynamicBuffers;
+
+	//   Dynamic-       
+	void retireDynamicBuffers(bool all);
+
+	//  :    uint32_t    
+	const uint32_t* fetchIndices(const IndexBufferView& ib, uint32_t startIndex, uint32_t indexCount);
+	void assembleTriangles(const uint32_t* indices, uint32_t indexCount, PrimitiveTopology topology, bool restart,
+						   uint32_t restartIndex);
+
+	//  :  ,     
+	void drawIndexedBatch(const DrawIndexedIndirectArgs* draws, uint32_t drawCount, const DrawBounds* bounds);
+	void captureDrawState();
+	void prepareDraw(const DrawIndexedIndirectArgs& args);
+	void prepareMeshlet(const MeshletMesh& mesh, const Meshlet& meshlet);
+	void submitPreparedDraws();
+	void flushBatch(uint32_t vertexCount);
+	void transformVertices();
+	void drawTriangles();
+
+	//     (DeviceCulling.cpp)
+	bool isCulled(const DrawBounds& bounds) const;
+	//    m_meshletVisible; HiZ -     
+	// (,   greater -      samples  )
+	void cullMeshlets(const MeshletMesh& mesh, const float4x4& world, uint32_t cullFlags);
+	void buildHiZ(const float* depth, int2 size, int samples, bool greater);
+	struct HiZLevel
+	{
+		int Width, Height;
+		std::vector<float> Depth;
+	};
+	std::vector<HiZLevel> m_hiZ;
+	std::vector<uint8_t> m_meshletVisible;
+	PipelineStatistics m_stats;
+	//    DeviceContext::SetPredication
+	bool isPredicatedOff() const;
+
+	//   .       
+	// ( -   -    ),    
+	std::vector<OcclusionQuery*> m_activeQueries;
+	struct alignas(64) TileSamples
+	{
+		uint64_t Passed;
+	};
+	std::vector<TileSamples> m_tileSamples;
+
+	//    .       .
+	//     tileSize    [areaMin, areaMax] (  )
+	void buildTiles(int2 areaMin, int2 areaMax);
+	void binTriangles(const TransformedVertices& transformedVerts, const std::vector<int3>& triangles);
 	void renderTilesMultithreaded();
 	void renderTilesSingleThreaded();
-	void RasterizeTriangleTile(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2, int2 tileMin, int2 tileMax);
-	void RasterizeTriangleTileSSE(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2, int2 tileMin, int2 tileMax);
+	uint64_t RasterizeTriangleTile(const int3& tri, int2 tileMin, int2 tileMax);
+	uint64_t RasterizeTriangleTileSSE(const int3& tri, int2 tileMin, int2 tileMax);
+	//       8x8 (m_smallTriangles):   4 ,
+	//    2x2   SIMD-
+	uint64_t RasterizeSmallTrianglesSSE(const int* triIndices, int count, int2 tileMin, int2 tileMax);
+	// 4x MSAA:     ,   -    
+	uint64_t RasterizeTriangleTileMSAA(const int3& tri, int2 tileMin, int2 tileMax);
+	//   :       varyings  
+	uint64_t RasterizeTriangleTileDepth(const int3& tri, int2 tileMin, int2 tileMax);
 	void renderTile(int tileIndex);
 	void renderTileQuad(int tileIndex);
+	//  :      mask      (x, y)
+	//    
+	void writeQuad(const PixelQuadOutput& color, int mask, int x, int y);
+	//    : coverage - 16    (. IRenderTarget::write_quad_samples)
+	void writeQuadSamples(const PixelQuadOutput& color, int coverage, int x, int y);
+	//    BlendState      
+	void setupOutputMerger();
 };
 
 SOFTX_END
@@ -3,6 +3,8 @@
 #include "LibInternal.h"
 #include "Types.h"
 #include "RenderTargetInterface.h"
+#include "Texture.h"
+#include "DepthBuffer.h"
 
 SOFTX_BEGIN
 
@@ -19,19 +21,78 @@ class SOFTX_API DeviceContext
 	void SetPixelShader(PixelShader shader);
 	PixelShader GetPixelShader() const;
 
-	//     
+	//    varyings. varyingCount -   
+	//   ()   ();   
+	void SetVertexProgram(VertexProgram program, uint32_t varyingCount);
+	VertexProgram GetVertexProgram() const;
+	uint32_t GetVertexVaryingCount() const;
+
+	void SetPixelProgram(PixelProgram program, uint32_t varyingCount);
+	PixelProgram GetPixelProgram() const;
+	uint32_t GetPixelVaryingCount() const;
+
+	//     2x2.     :
+	// SetPixelShader  SetPixelProgram      (    )
+	void SetQuadPixelProgram(QuadPixelProgram program, uint32_t varyingCount);
+	QuadPixelProgram GetQuadPixelProgram() const;
+
+	//     
+	void SetInputLayout(const InputLayout& layout);
+	InputLayout GetInputLayout() const;
+
+	//     .       (BufferPtr),
+	//      
 	void SetVertexBuffer(const VertexBuffer& buffer);
+	void SetVertexBuffer(const VertexBufferView& view);
 	VertexBuffer GetVertexBuffer() const;
+	const VertexBufferView& GetVertexBufferView() const;
 
 	void SetIndexBuffer(const IndexBuffer& buffer);
-	IndexBuffer GetIndexBuffer() const;
+	void SetIndexBuffer(const IndexBufferView& view);
+	IndexBuffer GetIndexBuffer() const; //   IndexFormat::UInt32
+	const IndexBufferView& GetIndexBufferView() const;
+
+	//     InputClassification::PerInstance ( - Stride  )
+	void SetInstanceBuffer(const VertexBufferView& view);
+	const VertexBufferView& GetInstanceBufferView() const;
 
 	void SetConstantBuffer(const ConstantBuffer& buffer);
 	ConstantBuffer GetConstantBuffer() const;
 
+	//     (PixelInput::Samplers / PixelQuadInput::Samplers)
+	void SetSampler(uint32_t slot, const SamplerState& sampler);
+	const SamplerState& GetSampler(uint32_t slot) const;
+	const SamplerState* GetSamplers() const;
+
 	//     
 	void SetRenderTarget(IRenderTarget* target);
-	IRenderTarget* GetRenderTarget() const;
+	IRenderTarget* GetRenderTarget(uint32_t slot = 0) const;
+	//     (MRT),     :
+	//  i  PixelQuadOutput::Target(i).   MAX_RENDER_TARGETS
+	void SetRenderTargets(uint32_t count, IRenderTarget* const* targets);
+	uint32_t GetRenderTargetCount() const;
+
+	//       
+	void SetBlendState(const BlendState& state);
+	const BlendState& GetBlendState() const;
+
+	//    ( ); nullptr -   .
+	//          (Z-prepass,  ):
+	//     , varyings     
+	void SetDepthTarget(DepthBuffer* target);
+	DepthBuffer* GetDepthTarget() const;
+
+	void SetDepthFunc(DepthFunc func);
+	DepthFunc GetDepthFunc() const;
+
+	// false -    (-  )
+	void SetDepthWrite(bool enable);
+	bool GetDepthWrite() const;
+
+	//  :  ,     .
+	// nullptr -  .   ,  
+	void SetPredication(const OcclusionQuery* query);
+	const OcclusionQuery* GetPredication() const;
 
 	//    
 	void SetCullMode(CullMode mode);
@@ -40,9 +101,41 @@ class SOFTX_API DeviceContext
 	void SetFillMode(FillMode mode);
 	FillMode GetFillMode() const;
 
+	//  
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	PrimitiveTopology GetPrimitiveTopology() const;
+
+	//  strip/fan   0xFFFF / 0xFFFFFFFF (. IndexBufferView::RestartIndex)
+	void SetPrimitiveRestart(bool enable);
+	bool GetPrimitiveRestart() const;
+
+	//      DrawBounds: clip = ViewProjection * World * p,
+	//   -w <= x, y <= w, 0 <= z <= w (  D3D)
+	void SetViewProjection(const float4x4& viewProjection);
+	const float4x4& GetViewProjection() const;
+
+	//     (BoundsType::None -  )
+	void SetDrawBounds(const DrawBounds& bounds);
+	const DrawBounds& GetDrawBounds() const;
+
 	// 
 	void SetViewport(const Viewport& vp);
-	Viewport GetViewport() const;
+	Viewport GetViewport(uint32_t slot = 0) const;
+	//   (  MAX_VIEWPORTS):     
+	//  Varyings::ViewportIndex,          .
+	//  (         )    
+	void SetViewports(uint32_t count, const Viewport* viewports);
+	uint32_t GetViewportCount() const;
+
+	//  :  i     i,
+	//     ,  .       
+	//  DrawFullScreenQuad ( 0);     
+	void SetScissorEnable(bool enable);
+	bool GetScissorEnable() const;
+	void SetScissorRect(const ScissorRect& rect);
+	void SetScissorRects(uint32_t count, const ScissorRect* rects);
+	const ScissorRect& GetScissorRect(uint32_t slot = 0) const;
+	uint32_t GetScissorRectCount() const;
 
 	//  
 	void SetTileRenderingState(bool enable);
@@ -54,22 +147,48 @@ class SOFTX_API DeviceContext
 	//    
 	//  true,     
 	//     ,       ( false)
-	bool Validate(std::string* errorMsg = nullptr) const;
+	// indexed = false -     ( )
+	bool Validate(std::string* errorMsg = nullptr, bool indexed = true) const;
 
   private:
 	VertexShader m_VertexShader;
 	PixelShader m_PixelShader;
 
-	VertexBuffer m_VertexBuffer;
-	IndexBuffer m_IndexBuffer;
+	VertexProgram m_VertexProgram;
+	PixelProgram m_PixelProgram;
+	QuadPixelProgram m_QuadPixelProgram;
+	uint32_t m_VertexVaryingCount;
+	uint32_t m_PixelVaryingCount;
+
+	InputLayout m_InputLayout;
+
+	VertexBufferView m_VertexBuffer;
+	IndexBufferView m_IndexBuffer;
+	VertexBufferView m_InstanceBuffer;
 	ConstantBuffer m_ConstantBuffer;
+	SamplerState m_Samplers[MAX_SAMPLERS];
 
-	IRenderTarget* m_RenderTarget;
+	IRenderTarget* m_RenderTargets[MAX_RENDER_TARGETS];
+	uint32_t m_RenderTargetCount;
+	BlendState m_BlendState;
+	DepthBuffer* m_DepthTarget;
+	DepthFunc m_DepthFunc;
+	bool m_DepthWrite;
+	const OcclusionQuery* m_Predication;
 
 	CullMode m_cullMode;
 	FillMode m_fillMode;
+	PrimitiveTopology m_topology;
+	bool m_primitiveRestart;
+
+	float4x4 m_ViewProjection;
+	DrawBounds m_DrawBounds;
 
-	Viewport m_Viewport;
+	Viewport m_Viewports[MAX_VIEWPORTS];
+	uint32_t m_ViewportCount;
+	ScissorRect m_ScissorRects[MAX_VIEWPORTS];
+	uint32_t m_ScissorRectCount;
+	bool m_ScissorEnable;
 
 	bool m_EnableTiledRendering;
 	uint32_t m_TileSize;
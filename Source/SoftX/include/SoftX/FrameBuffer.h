@@ -2,6 +2,7 @@
 #include <windows.h>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
@@ -74,6 +75,123 @@ class SOFTX_API Framebuffer : public IRenderTarget
 		return 0;
 	}
 
+	//    float4 (RGBA)
+	float4 read_pixel(int2 coords) const override
+	{
+		uint32_t c = get_pixel(coords);
+		const float scale = 1.0f / 255.0f;
+		return float4(((c >> 16) & 0xFF) * scale, ((c >> 8) & 0xFF) * scale, (c & 0xFF) * scale, (c >> 24) * scale);
+	}
+
+	//  :    BGRA8  SSE-,
+	//     -  64-  ,  -   mask
+	void write_quad(int x, int y, const __m128 rgba[4], int mask) override
+	{
+		__m128i packed = packBGRA(rgba);
+		if (x < 0 || y < 0 || x + 1 >= m_width || y + 1 >= m_height)
+		{
+			alignas(16) uint32_t pixels[4];
+			_mm_store_si128((__m128i*)pixels, packed);
+			for (int i = 0; i < 4; ++i)
+				if (mask & (1 << i))
+					set_pixel(int2(x + (i & 1), y + (i >> 1)), pixels[i]);
+			return;
+		}
+
+		uint32_t* row0 = m_pixels.data() + (size_t)y * m_width + x;
+		uint32_t* row1 = row0 + m_width;
+		if (mask != 0xF)
+		{
+			//   mask    ,    ,
+			//     mask,  -- 
+			alignas(16) uint32_t pixels[4];
+			_mm_store_si128((__m128i*)pixels, packed);
+			for (int i = 0; i < 4; ++i)
+				if (mask & (1 << i))
+					((i >> 1) ? row1 : row0)[i & 1] = pixels[i];
+			return;
+		}
+		_mm_storel_epi64((__m128i*)row0, packed);
+		_mm_storel_epi64((__m128i*)row1, _mm_unpackhi_epi64(packed, packed));
+	}
+
+	void read_quad(int x, int y, __m128 rgba[4]) const override
+	{
+		__m128i packed;
+		if (x < 0 || y < 0 || x + 1 >= m_width || y + 1 >= m_height)
+		{
+			packed = _mm_setr_epi32(get_pixel(int2(x, y)), get_pixel(int2(x + 1, y)), get_pixel(int2(x, y + 1)),
+									get_pixel(int2(x + 1, y + 1)));
+		}
+		else
+		{
+			const uint32_t* row0 = m_pixels.data() + (size_t)y * m_width + x;
+			packed = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)row0),
+										_mm_loadl_epi64((const __m128i*)(row0 + m_width)));
+		}
+		unpackBGRA(packed, rgba);
+	}
+
+	//  :       packBGRA,     
+	void write_span(int x, int y, int count, const float4* colors) override
+	{
+		if (!clip_span(x, y, count, colors))
+			return;
+		uint32_t* row = m_pixels.data() + (size_t)y * m_width + x;
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 c[4] = {colors[i].v, colors[i + 1].v, colors[i + 2].v, colors[i + 3].v};
+			_MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+			_mm_storeu_si128((__m128i*)(row + i), packBGRA(c));
+		}
+		for (; i < count; ++i)
+			row[i] = float4ToBGRA(colors[i]);
+	}
+
+	void read_span(int x, int y, int count, float4* colors) const override
+	{
+		if (!clip_span(x, y, count, colors))
+			return;
+		const uint32_t* row = m_pixels.data() + (size_t)y * m_width + x;
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 c[4];
+			unpackBGRA(_mm_loadu_si128((const __m128i*)(row + i)), c);
+			_MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+			for (int k = 0; k < 4; ++k)
+				colors[i + k] = c[k];
+		}
+		for (; i < count; ++i)
+			colors[i] = read_pixel(int2(x + i, y));
+	}
+
+	//     (0xAARRGGBB)
+	void write_span(int x, int y, int count, const uint32_t* colors)
+	{
+		if (clip_span(x, y, count, colors))
+			std::memcpy(m_pixels.data() + (size_t)y * m_width + x, colors, count * sizeof(uint32_t));
+	}
+	void read_span(int x, int y, int count, uint32_t* colors) const
+	{
+		if (clip_span(x, y, count, colors))
+			std::memcpy(colors, m_pixels.data() + (size_t)y * m_width + x, count * sizeof(uint32_t));
+	}
+
+	RenderTargetFormat format() const override
+	{
+		return RenderTargetFormat::BGRA8;
+	}
+	uint8_t* raw_data() override
+	{
+		return reinterpret_cast<uint8_t*>(m_pixels.data());
+	}
+	size_t row_pitch() const override
+	{
+		return (size_t)m_width * sizeof(uint32_t);
+	}
+
 	//      GDI
 	const uint32_t* data() const
 	{
@@ -143,7 +261,48 @@ class SOFTX_API Framebuffer : public IRenderTarget
 						  DIB_RGB_COLORS);
 	}
 
+	//     SoA (rgba[0] -    ..)   0xAARRGGBB.
+	//     float4; NaN  0 (max   )
+	static __m128i packBGRA(const __m128 rgba[4])
+	{
+		const __m128 scale = _mm_set1_ps(255.0f);
+		__m128i c[4];
+		for (int ch = 0; ch < 4; ++ch)
+		{
+			__m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(rgba[ch], scale), _mm_setzero_ps()), scale);
+			c[ch] = _mm_cvttps_epi32(v);
+		}
+		__m128i argb = _mm_or_si128(_mm_slli_epi32(c[3], 24), _mm_slli_epi32(c[0], 16));
+		return _mm_or_si128(argb, _mm_or_si128(_mm_slli_epi32(c[1], 8), c[2]));
+	}
+
+	// :  0xAARRGGBB  SoA RGBA
+	static void unpackBGRA(__m128i packed, __m128 rgba[4])
+	{
+		const __m128i byte = _mm_set1_epi32(0xFF);
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+		rgba[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 16), byte)), scale);
+		rgba[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 8), byte)), scale);
+		rgba[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, byte)), scale);
+		rgba[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(packed, 24)), scale);
+	}
+
   private:
+	//     ; colors    x. false -   
+	template <typename T> bool clip_span(int& x, int y, int& count, T*& colors) const
+	{
+		if (y < 0 || y >= m_height)
+			return false;
+		if (x < 0)
+		{
+			colors -= x;
+			count += x;
+			x = 0;
+		}
+		count = std::min(count, m_width - x);
+		return count > 0;
+	}
+
 	//  float4 (RGBA)  32- BGRA (0xAARRGGBB)
 	static uint32_t float4ToBGRA(const float4& c)
 	{
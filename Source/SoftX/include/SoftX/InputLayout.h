@@ -0,0 +1,176 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#include "Math.h"
+#include "LibInternal.h"
+
+SOFTX_BEGIN
+
+//      
+enum class VertexFormat
+{
+	Float1,	   // float
+	Float2,	   // float2
+	Float3,	   // float3
+	Float4,	   // float4
+	UByte4Norm // 4 x uint8,   [0..1] ( )
+};
+
+//     
+enum class InputClassification
+{
+	PerVertex,	//  ,  - 
+	PerInstance //   (DeviceContext::SetInstanceBuffer),  - 
+};
+
+//     ( D3D11_INPUT_ELEMENT_DESC)
+struct InputElement
+{
+	const char* SemanticName; //   ("POSITION", "NORMAL", ...)
+	VertexFormat Format;	  //    
+	uint32_t Offset;		  //     ()  
+	InputClassification Classification = InputClassification::PerVertex;
+};
+
+//   :     .
+//   (slot) -      .
+class InputLayout
+{
+  public:
+	InputLayout()
+	{
+	}
+	InputLayout(std::initializer_list<InputElement> elements) : m_elements(elements)
+	{
+	}
+
+	void Add(const InputElement& element)
+	{
+		m_elements.push_back(element);
+	}
+	size_t ElementCount() const
+	{
+		return m_elements.size();
+	}
+	const InputElement& GetElement(size_t slot) const
+	{
+		return m_elements[slot];
+	}
+	bool IsEmpty() const
+	{
+		return m_elements.empty();
+	}
+
+	//      
+	bool HasPerInstanceElements() const
+	{
+		for (const InputElement& e : m_elements)
+		{
+			if (e.Classification == InputClassification::PerInstance)
+				return true;
+		}
+		return false;
+	}
+
+	//    , -1   
+	int FindElement(const char* semanticName) const
+	{
+		for (size_t i = 0; i < m_elements.size(); ++i)
+		{
+			if (std::strcmp(m_elements[i].SemanticName, semanticName) == 0)
+				return (int)i;
+		}
+		return -1;
+	}
+
+  private:
+	std::vector<InputElement> m_elements;
+};
+
+//   :     (  ),   InputLayout.
+//      D3D: (0, 0, 0, 1).
+class VertexAttributes
+{
+  public:
+	VertexAttributes(const uint8_t* vertex, const InputLayout& layout, uint32_t vertexID,
+					 const uint8_t* instance = nullptr, uint32_t instanceID = 0)
+		: m_vertex(vertex), m_instance(instance), m_layout(layout), m_vertexID(vertexID), m_instanceID(instanceID)
+	{
+	}
+
+	float4 Get(uint32_t slot) const
+	{
+		if (slot >= m_layout.ElementCount())
+			return float4(0, 0, 0, 1);
+
+		const InputElement& e = m_layout.GetElement(slot);
+		const uint8_t* base = e.Classification == InputClassification::PerInstance ? m_instance : m_vertex;
+		if (!base)
+			return float4(0, 0, 0, 1);
+		const uint8_t* src = base + e.Offset;
+		float f[4] = {0, 0, 0, 1};
+		switch (e.Format)
+		{
+		case VertexFormat::Float1:
+			std::memcpy(f, src, sizeof(float));
+			break;
+		case VertexFormat::Float2:
+			std::memcpy(f, src, sizeof(float) * 2);
+			break;
+		case VertexFormat::Float3:
+			std::memcpy(f, src, sizeof(float) * 3);
+			break;
+		case VertexFormat::Float4:
+			return float4(_mm_loadu_ps(reinterpret_cast<const float*>(src)));
+		case VertexFormat::UByte4Norm: {
+			int packed;
+			std::memcpy(&packed, src, sizeof(packed)); //     
+			__m128i bytes = _mm_cvtsi32_si128(packed);
+			__m128i ints = _mm_cvtepu8_epi32(bytes);
+			return float4(_mm_mul_ps(_mm_cvtepi32_ps(ints), _mm_set1_ps(1.0f / 255.0f)));
+		}
+		}
+		return float4(_mm_loadu_ps(f));
+	}
+
+	float3 Get3(uint32_t slot) const
+	{
+		float4 v = Get(slot);
+		return float3(v.x, v.y, v.z);
+	}
+
+	float2 Get2(uint32_t slot) const
+	{
+		float4 v = Get(slot);
+		return float2(v.x, v.y);
+	}
+
+	float Get1(uint32_t slot) const
+	{
+		return Get(slot).x;
+	}
+
+	//     (SV_VertexID)
+	uint32_t VertexID() const
+	{
+		return m_vertexID;
+	}
+
+	//      (SV_InstanceID,   startInstance)
+	uint32_t InstanceID() const
+	{
+		return m_instanceID;
+	}
+
+  private:
+	const uint8_t* m_vertex;
+	const uint8_t* m_instance;
+	const InputLayout& m_layout;
+	uint32_t m_vertexID;
+	uint32_t m_instanceID;
+};
+
+SOFTX_END
@@ -4,6 +4,7 @@
 #include <cmath>         //  fabs, sqrt, sinf, cosf, tanf
 #include <algorithm>     //  std::min, std::max
 #include <cstdlib>       //  std::abs (int)
+#include <cstring>       //  std::memcpy
 
 #include "LibInternal.h"
 
@@ -157,6 +158,12 @@ inline float3 max(const float3& a, const float3& b) {
     return float3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
 }
 inline float3 abs(const float3& v) { return float3(std::abs(v.x), std::abs(v.y), std::abs(v.z)); }
+//  index  float3   stride  ( ;   )
+inline float3 loadFloat3(const float* data, size_t stride, size_t index) {
+    float p[3];
+    std::memcpy(p, reinterpret_cast<const char*>(data) + index * stride, sizeof(p));
+    return float3(p[0], p[1], p[2]);
+}
 
 // ==================== int2 ====================
 struct int2 {
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include "LibInternal.h"
+#include "InputLayout.h"
+#include "Types.h"
+
+SOFTX_BEGIN
+
+// -   ( ,  uint32_t).
+//  : OptimizeVertexCache -> OptimizeOverdraw -> OptimizeVertexFetchRemap.
+// destination    indices   ,  RemapVertexBuffer.
+
+//   FIFO-  
+struct VertexCacheStats
+{
+	uint32_t VerticesTransformed; //   =   
+	float ACMR;					  //    (0.5 -    )
+	float ATVR;					  //     (1.0 - )
+};
+
+//  ,      
+struct OverdrawStats
+{
+	uint32_t PixelsCovered; //    
+	uint32_t PixelsShaded;	// ,    (  )
+	float Overdraw;			// PixelsShaded / PixelsCovered (1.0 - )
+};
+
+//   :      -
+struct VertexFetchStats
+{
+	uint32_t BytesFetched;
+	float Overfetch; // BytesFetched / (  * stride), 1.0 - 
+};
+
+//         ( )
+SOFTX_API void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+								   size_t vertexCount);
+
+//    ,     
+// (     ).       ;
+// threshold -   ACMR     (1.05 =  5%).
+// positions - float3     positionStride .
+SOFTX_API void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+								const float* positions, size_t vertexCount, size_t positionStride,
+								float threshold = 1.05f);
+
+//        .
+// remap[old] = new  ~0u  ,    .     .
+SOFTX_API size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount,
+										  size_t vertexCount);
+
+//       
+SOFTX_API void RemapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+								const uint32_t* remap);
+SOFTX_API void RemapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t stride,
+								 const uint32_t* remap);
+
+//  
+SOFTX_API VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+											  uint32_t cacheSize = 16);
+SOFTX_API OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions,
+										size_t vertexCount, size_t positionStride);
+SOFTX_API VertexFetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+											  size_t stride);
+
+//     SoftX: ,    .
+//     "POSITION"  (Float3  Float4).
+//  false,           .
+SOFTX_API bool OptimizeMesh(VertexBuffer& vb, IndexBuffer& ib, const InputLayout& layout = DefaultInputLayout(),
+							float overdrawThreshold = 1.05f);
+
+SOFTX_END
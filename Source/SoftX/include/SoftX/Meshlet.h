@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "LibInternal.h"
+#include "InputLayout.h"
+#include "Types.h"
+
+SOFTX_BEGIN
+
+//   (  mesh shaders:     )
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 126;
+
+//          
+struct Meshlet
+{
+	uint32_t VertexOffset;	 //   MeshletMesh::Vertices
+	uint32_t TriangleOffset; //   MeshletMesh::Triangles ( 3   )
+	uint32_t VertexCount;
+	uint32_t TriangleCount;
+
+	BoundingSphere Bounds; //   
+	float3 ConeAxis;	   //    
+	float ConeCutoff;	   //     ; 1 -   
+};
+
+// ,   .      
+struct MeshletMesh
+{
+	std::vector<Meshlet> Meshlets;
+	std::vector<uint32_t> Vertices; //    
+	std::vector<uint8_t> Triangles; //     
+};
+
+//    Device::DrawMeshlets ( )
+enum MeshletCullFlags : uint32_t
+{
+	MESHLET_CULL_FRUSTUM = 1 << 0,	//     
+	MESHLET_CULL_BACKFACE = 1 << 1, //       ( CullMode::Back)
+	MESHLET_CULL_OCCLUSION = 1 << 2 // HiZ  ,      ( Less*  Greater*)
+};
+
+//         
+// (   OptimizeVertexCache). positions - float3   positionStride .
+//  false,    MESHLET_MAX_*,     
+//     vertexCount
+SOFTX_API bool BuildMeshlets(MeshletMesh& mesh, const uint32_t* indices, size_t indexCount, const float* positions,
+							 size_t vertexCount, size_t positionStride, uint32_t maxVertices = MESHLET_MAX_VERTICES,
+							 uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+//     SoftX;     "POSITION" 
+SOFTX_API bool BuildMeshlets(MeshletMesh& mesh, const VertexBuffer& vb, const IndexBuffer& ib,
+							 const InputLayout& layout = DefaultInputLayout(),
+							 uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+SOFTX_END
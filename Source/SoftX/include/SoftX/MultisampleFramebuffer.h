@@ -0,0 +1,204 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "Math.h"
+#include "Types.h"
+#include "FrameBuffer.h"
+#include "RenderTargetInterface.h"
+
+SOFTX_BEGIN
+
+//   4x MSAA:    MSAA_SAMPLE_COUNT  BGRA8 (0xAARRGGBB),
+//   (16   ).    ,   ,
+//   ;        (Device::ResolveMultisample)
+class SOFTX_API MultisampleFramebuffer : public IRenderTarget
+{
+  public:
+	MultisampleFramebuffer(int2 size) : m_width(size.x), m_height(size.y), m_samples((size_t)size.x * size.y)
+	{
+		clear(float4(0, 0, 0, 1));
+	}
+
+	//   
+	void clear(const float4& color) override
+	{
+		__m128 rgba[4] = {_mm_set1_ps(color.x), _mm_set1_ps(color.y), _mm_set1_ps(color.z), _mm_set1_ps(color.w)};
+		__m128i packed = Framebuffer::packBGRA(rgba);
+		std::fill(m_samples.begin(), m_samples.end(), packed);
+	}
+
+	//  :    
+	void set_pixel(int2 coords, const float4& color) override
+	{
+		if (!inside(coords.x, coords.y))
+			return;
+		__m128 rgba[4] = {_mm_set1_ps(color.x), _mm_set1_ps(color.y), _mm_set1_ps(color.z), _mm_set1_ps(color.w)};
+		m_samples[index(coords.x, coords.y)] = Framebuffer::packBGRA(rgba);
+	}
+
+	//    (  )
+	float4 read_pixel(int2 coords) const override
+	{
+		if (!inside(coords.x, coords.y))
+			return float4(0, 0, 0, 0);
+		__m128 rgba[4];
+		Framebuffer::unpackBGRA(m_samples[index(coords.x, coords.y)], rgba);
+		_MM_TRANSPOSE4_PS(rgba[0], rgba[1], rgba[2], rgba[3]);
+		__m128 sum = _mm_add_ps(_mm_add_ps(rgba[0], rgba[1]), _mm_add_ps(rgba[2], rgba[3]));
+		return float4(_mm_mul_ps(sum, _mm_set1_ps(1.0f / MSAA_SAMPLE_COUNT)));
+	}
+
+	//   ( ) -    mask
+	void write_quad(int x, int y, const __m128 rgba[4], int mask) override
+	{
+		int coverage = 0;
+		for (int i = 0; i < 4; ++i)
+			if (mask & (1 << i))
+				coverage |= 0xF << (i * 4);
+		write_quad_samples(x, y, rgba, coverage);
+	}
+
+	uint32_t sample_count() const override
+	{
+		return MSAA_SAMPLE_COUNT;
+	}
+
+	void write_quad_samples(int x, int y, const __m128 rgba[4], int coverage) override
+	{
+		__m128i packed = Framebuffer::packBGRA(rgba);
+		const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+		for (int i = 0; i < 4; ++i)
+		{
+			int samples = (coverage >> (i * 4)) & 0xF;
+			int px = x + (i & 1), py = y + (i >> 1);
+			if (samples == 0 || !inside(px, py))
+				continue;
+			//      ,    
+			__m128i color = _mm_shuffle_epi32(packed, 0);
+			if (i == 1) color = _mm_shuffle_epi32(packed, 0x55);
+			if (i == 2) color = _mm_shuffle_epi32(packed, 0xAA);
+			if (i == 3) color = _mm_shuffle_epi32(packed, 0xFF);
+			__m128i& dst = m_samples[index(px, py)];
+			if (samples != 0xF)
+			{
+				__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(samples), bits), _mm_setzero_si128());
+				color = _mm_blendv_epi8(color, dst, keep);
+			}
+			dst = color;
+		}
+	}
+
+	void write_quad_sample(int x, int y, int sample, const __m128 rgba[4], int mask) override
+	{
+		alignas(16) uint32_t pixels[4];
+		_mm_store_si128((__m128i*)pixels, Framebuffer::packBGRA(rgba));
+		for (int i = 0; i < 4; ++i)
+		{
+			int px = x + (i & 1), py = y + (i >> 1);
+			if ((mask & (1 << i)) && inside(px, py))
+				reinterpret_cast<uint32_t*>(&m_samples[index(px, py)])[sample] = pixels[i];
+		}
+	}
+
+	void read_quad_sample(int x, int y, int sample, __m128 rgba[4]) const override
+	{
+		alignas(16) uint32_t pixels[4] = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			int px = x + (i & 1), py = y + (i >> 1);
+			if (inside(px, py))
+				pixels[i] = reinterpret_cast<const uint32_t*>(&m_samples[index(px, py)])[sample];
+		}
+		Framebuffer::unpackBGRA(_mm_load_si128((const __m128i*)pixels), rgba);
+	}
+
+	//   [min, max] ()  dest:   
+	//  ,       16- .  BGRA8-
+	//    raw_data,   -  
+	void resolve(IRenderTarget& dest, int2 min, int2 max) const
+	{
+		min = int2(std::max(min.x, 0), std::max(min.y, 0));
+		max = int2(std::min({max.x, m_width - 1, dest.width() - 1}), std::min({max.y, m_height - 1, dest.height() - 1}));
+		if (min.x > max.x || min.y > max.y)
+			return;
+		int count = max.x - min.x + 1;
+		bool direct = dest.format() == RenderTargetFormat::BGRA8 && dest.raw_data();
+		std::vector<uint32_t> row(direct ? 0 : count + 3);
+		std::vector<float4> colors(direct ? 0 : count + 3);
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(2);
+		for (int y = min.y; y <= max.y; ++y)
+		{
+			const __m128i* src = m_samples.data() + index(min.x, y);
+			uint32_t* out = direct ? reinterpret_cast<uint32_t*>(dest.raw_data() + (size_t)y * dest.row_pitch()) + min.x
+								   : row.data();
+			int x = 0;
+			for (; x + 4 <= count; x += 4)
+			{
+				__m128i sum[4];
+				for (int i = 0; i < 4; ++i)
+				{
+					//  0 + 2  1 + 3  16- ,   
+					__m128i p = _mm_loadu_si128(src + x + i);
+					sum[i] = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpackhi_epi8(p, zero));
+				}
+				__m128i s01 = _mm_add_epi16(_mm_unpacklo_epi64(sum[0], sum[1]), _mm_unpackhi_epi64(sum[0], sum[1]));
+				__m128i s23 = _mm_add_epi16(_mm_unpacklo_epi64(sum[2], sum[3]), _mm_unpackhi_epi64(sum[2], sum[3]));
+				s01 = _mm_srli_epi16(_mm_add_epi16(s01, round), 2);
+				s23 = _mm_srli_epi16(_mm_add_epi16(s23, round), 2);
+				_mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(s01, s23));
+			}
+			for (; x < count; ++x)
+			{
+				__m128i p = _mm_loadu_si128(src + x);
+				__m128i s = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpackhi_epi8(p, zero));
+				s = _mm_add_epi16(s, _mm_srli_si128(s, 8));
+				s = _mm_srli_epi16(_mm_add_epi16(s, round), 2);
+				out[x] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(s, s));
+			}
+			if (direct)
+				continue;
+
+			for (x = 0; x < count; x += 4)
+			{
+				__m128 c[4];
+				Framebuffer::unpackBGRA(_mm_loadu_si128((const __m128i*)(row.data() + x)), c);
+				_MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+				for (int i = 0; i < 4; ++i)
+					colors[x + i] = c[i];
+			}
+			dest.write_span(min.x, y, count, colors.data());
+		}
+	}
+
+	int width() const override
+	{
+		return m_width;
+	}
+	int height() const override
+	{
+		return m_height;
+	}
+	int2 size() const override
+	{
+		return int2(m_width, m_height);
+	}
+
+  private:
+	bool inside(int x, int y) const
+	{
+		return x >= 0 && x < m_width && y >= 0 && y < m_height;
+	}
+	size_t index(int x, int y) const
+	{
+		return (size_t)y * m_width + x;
+	}
+
+	int m_width, m_height;
+	std::vector<__m128i> m_samples; //     
+};
+
+SOFTX_END
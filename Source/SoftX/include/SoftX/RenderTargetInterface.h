@@ -5,6 +5,14 @@
 
 SOFTX_BEGIN
 
+//     (    raw_data)
+enum class RenderTargetFormat
+{
+	Unknown, //   
+	BGRA8,	 // uint32_t 0xAARRGGBB
+	RGBA32F	 //  float (__m128)
+};
+
 class SOFTX_API IRenderTarget
 {
   public:
@@ -16,6 +24,85 @@ class SOFTX_API IRenderTarget
 	//  
 	virtual void set_pixel(int2 coords, const float4& color) = 0;
 
+	//   ( ),    RGBA
+	virtual float4 read_pixel(int2 coords) const = 0;
+
+	//  2x2     (x, y)  SoA (rgba[0] -      ..),
+	//    (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1).
+	//    mask;   -   set_pixel
+	virtual void write_quad(int x, int y, const __m128 rgba[4], int mask)
+	{
+		__m128 c0 = rgba[0], c1 = rgba[1], c2 = rgba[2], c3 = rgba[3];
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		const __m128 pixels[4] = {c0, c1, c2, c3};
+		for (int i = 0; i < 4; ++i)
+			if (mask & (1 << i))
+				set_pixel(int2(x + (i & 1), y + (i >> 1)), float4(pixels[i]));
+	}
+
+	//    SoA ( );   -   read_pixel
+	virtual void read_quad(int x, int y, __m128 rgba[4]) const
+	{
+		for (int i = 0; i < 4; ++i)
+			rgba[i] = read_pixel(int2(x + (i & 1), y + (i >> 1))).v;
+		_MM_TRANSPOSE4_PS(rgba[0], rgba[1], rgba[2], rgba[3]);
+	}
+
+	//   y  count    x (RGBA)   .
+	//   -   set_pixel / read_pixel
+	virtual void write_span(int x, int y, int count, const float4* colors)
+	{
+		for (int i = 0; i < count; ++i)
+			set_pixel(int2(x + i, y), colors[i]);
+	}
+	virtual void read_span(int x, int y, int count, float4* colors) const
+	{
+		for (int i = 0; i < count; ++i)
+			colors[i] = read_pixel(int2(x + i, y));
+	}
+
+	// :     (1  MSAA_SAMPLE_COUNT).
+	//   - 16 ,  i * 4 + s -  s  i  (    write_quad)
+	virtual uint32_t sample_count() const
+	{
+		return 1;
+	}
+	//        ;   -    write_quad
+	virtual void write_quad_samples(int x, int y, const __m128 rgba[4], int coverage)
+	{
+		int mask = 0;
+		for (int i = 0; i < 4; ++i)
+			if (coverage & (0xF << (i * 4)))
+				mask |= 1 << i;
+		write_quad(x, y, rgba, mask);
+	}
+	//  sample   (   );   -  
+	virtual void write_quad_sample(int x, int y, int sample, const __m128 rgba[4], int mask)
+	{
+		(void)sample;
+		write_quad(x, y, rgba, mask);
+	}
+	virtual void read_quad_sample(int x, int y, int sample, __m128 rgba[4]) const
+	{
+		(void)sample;
+		read_quad(x, y, rgba);
+	}
+
+	//    :  y   raw_data() + y * row_pitch() .
+	// nullptr,     ( Unknown)
+	virtual RenderTargetFormat format() const
+	{
+		return RenderTargetFormat::Unknown;
+	}
+	virtual uint8_t* raw_data()
+	{
+		return nullptr;
+	}
+	virtual size_t row_pitch() const
+	{
+		return 0;
+	}
+
 	// 
 	virtual int width() const = 0;
 	virtual int height() const = 0;
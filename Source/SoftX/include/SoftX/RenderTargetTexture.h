@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 
 #include "RenderTargetInterface.h"
 #include "Texture.h"
@@ -34,6 +35,76 @@ class SOFTX_API RenderTargetTexture : public IRenderTarget
 		m_texture.stream_write(coords, col);
 	}
 
+	float4 read_pixel(int2 coords) const override
+	{
+		return float4(m_texture.read(coords));
+	}
+
+	void write_quad(int x, int y, const __m128 rgba[4], int mask) override
+	{
+		__m128 c0 = rgba[0], c1 = rgba[1], c2 = rgba[2], c3 = rgba[3];
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		const __m128 pixels[4] = {c0, c1, c2, c3};
+		for (int i = 0; i < 4; ++i)
+			if (mask & (1 << i))
+				m_texture.stream_write(int2(x + (i & 1), y + (i >> 1)), pixels[i]);
+	}
+
+	void read_quad(int x, int y, __m128 rgba[4]) const override
+	{
+		//        
+		__m128i xs = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 0, 1));
+		__m128i ys = _mm_add_epi32(_mm_set1_epi32(y), _mm_setr_epi32(0, 0, 1, 1));
+		xs = _mm_max_epi32(_mm_min_epi32(xs, _mm_set1_epi32(width() - 1)), _mm_setzero_si128());
+		ys = _mm_max_epi32(_mm_min_epi32(ys, _mm_set1_epi32(height() - 1)), _mm_setzero_si128());
+		m_texture.fetch4(0, xs, ys, rgba);
+	}
+
+	//  :   Linear   
+	void write_span(int x, int y, int count, const float4* colors) override
+	{
+		if (!clip_span(x, y, count, colors))
+			return;
+		if (m_texture.layout() == TextureLayout::Linear)
+		{
+			__m128* row = m_texture.data() + (size_t)y * width() + x;
+			for (int i = 0; i < count; ++i)
+				_mm_stream_ps(reinterpret_cast<float*>(row + i), colors[i].v);
+			return;
+		}
+		for (int i = 0; i < count; ++i)
+			m_texture.stream_write(int2(x + i, y), colors[i].v);
+	}
+
+	void read_span(int x, int y, int count, float4* colors) const override
+	{
+		if (!clip_span(x, y, count, colors))
+			return;
+		if (m_texture.layout() == TextureLayout::Linear)
+		{
+			const __m128* row = m_texture.data() + (size_t)y * width() + x;
+			for (int i = 0; i < count; ++i)
+				colors[i] = row[i];
+			return;
+		}
+		for (int i = 0; i < count; ++i)
+			colors[i] = m_texture.read(int2(x + i, y));
+	}
+
+	RenderTargetFormat format() const override
+	{
+		return m_texture.layout() == TextureLayout::Linear ? RenderTargetFormat::RGBA32F
+															: RenderTargetFormat::Unknown;
+	}
+	uint8_t* raw_data() override
+	{
+		return format() == RenderTargetFormat::Unknown ? nullptr : reinterpret_cast<uint8_t*>(m_texture.data());
+	}
+	size_t row_pitch() const override
+	{
+		return format() == RenderTargetFormat::Unknown ? 0 : (size_t)width() * sizeof(__m128);
+	}
+
 	int width() const override
 	{
 		return m_texture.width();
@@ -58,6 +129,20 @@ class SOFTX_API RenderTargetTexture : public IRenderTarget
 	}
 
   private:
+	template <typename T> bool clip_span(int& x, int y, int& count, T*& colors) const
+	{
+		if (y < 0 || y >= height())
+			return false;
+		if (x < 0)
+		{
+			colors -= x;
+			count += x;
+			x = 0;
+		}
+		count = std::min(count, width() - x);
+		return count > 0;
+	}
+
 	TextureRGBA32F m_texture;
 };
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+#include "LibInternal.h"
+
+SOFTX_BEGIN
+
+//   framesInFlight  ,    .
+//  -  ;   N  
+//  framesInFlight ,       .
+class RingAllocator {
+public:
+    RingAllocator(size_t blockSize, uint32_t framesInFlight)
+        : m_blockSize(blockSize), m_frames(framesInFlight), m_frameIndex(0) {}
+
+    void* Allocate(size_t size, size_t alignment = 16) {
+        Frame& frame = m_frames[m_frameIndex % m_frames.size()];
+        while (true) {
+            if (frame.current < frame.blocks.size()) {
+                Block& block = frame.blocks[frame.current];
+                uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+                uintptr_t ptr = (base + block.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+                if (ptr + size <= base + block.capacity) {
+                    block.used = ptr + size - base;
+                    return reinterpret_cast<void*>(ptr);
+                }
+                //   -      
+                ++frame.current;
+                continue;
+            }
+            //    -  ,       
+            Block block;
+            block.capacity = std::max(m_blockSize, size + alignment);
+            block.memory.reset(new uint8_t[block.capacity]);
+            block.used = 0;
+            frame.blocks.push_back(std::move(block));
+        }
+    }
+
+    //  :   ,   framesInFlight  
+    void FinishFrame() {
+        ++m_frameIndex;
+        Frame& frame = m_frames[m_frameIndex % m_frames.size()];
+        for (auto& block : frame.blocks)
+            block.used = 0;
+        frame.current = 0;
+    }
+
+    uint64_t FrameIndex() const { return m_frameIndex; }
+    uint32_t FramesInFlight() const { return (uint32_t)m_frames.size(); }
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t capacity = 0;
+        size_t used = 0;
+    };
+    struct Frame {
+        std::vector<Block> blocks;
+        size_t current = 0;
+    };
+
+    size_t m_blockSize;
+    std::vector<Frame> m_frames;
+    uint64_t m_frameIndex;
+};
+
+SOFTX_END
@@ -4,9 +4,14 @@
 
 #include "LibInternal.h"
 #include "Math.h"
+#include "InputLayout.h"
+#include "Buffer.h"
 #include "Types.h"
 #include "Framebuffer.h"
 #include "DepthBuffer.h"
 #include "RenderTargetTexture.h"
+#include "MultisampleFramebuffer.h"
 #include "DeviceContext.h"
 #include "Device.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
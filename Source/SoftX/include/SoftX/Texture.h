@@ -4,6 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include <cassert>
+#include <cfloat>
 #include <fstream>
 #include <iostream>
 
@@ -12,11 +13,57 @@
 
 SOFTX_BEGIN
 
+class ThreadPool;
+
+//     -
+enum class MipFilter
+{
+	Box,   //  2x2
+	Kaiser // windowed sinc 6x6   :  ,     
+};
+
+//      [0, 1]
+enum class TextureAddressMode
+{
+	Wrap,	//  
+	Clamp,	//  
+	Mirror, //      
+	Border	//   (SamplerDesc::BorderColor;     -  )
+};
+
+//   SamplerState
+enum class TextureFilter
+{
+	Point,	  //    -
+	Bilinear, //    -
+	Trilinear //       
+};
+
+//   TextureRGBA32F  
+enum class TextureLayout
+{
+	Linear, // 
+	Tiled	//  4x4 ,   Z- (Morton):  2x2 -  -,
+			//  - 256  ,         
+};
+
+//    (TextureCompact)
+enum class TextureFormat
+{
+	RGBA8, // 4 : RGBA unorm
+	R8,	   // 1 :   unorm (G = B = 0, A = 1)
+	RG16F, // 4 :   half float (B = 0, A = 1)
+	BC1,   // 8    4x4:  565,  0  1
+	BC3	   // 16    4x4:    BC1   
+};
+
 class SOFTX_API TextureRGBA32F
 {
   public:
-	TextureRGBA32F(int2 size) : m_width(size.x), m_height(size.y), m_pixels(size.x * size.y)
+	TextureRGBA32F(int2 size, TextureLayout layout = TextureLayout::Linear)
+		: m_width(size.x), m_height(size.y), m_layout(layout), m_pixels(level_size(size.x, size.y, layout))
 	{
+		m_levels.push_back({m_width, m_height, 0});
 		//  
 		__m128 zero = _mm_setzero_ps();
 		for (auto& p : m_pixels)
@@ -29,10 +76,10 @@ class SOFTX_API TextureRGBA32F
 	__m128 read(int2 coords) const
 	{
 		assert(coords.x >= 0 && coords.x < m_width && coords.y >= 0 && coords.y < m_height);
-		return m_pixels[coords.y * m_width + coords.x];
+		return m_pixels[texel_index(m_levels[0], coords.x, coords.y)];
 	}
 
-	//    ( )
+	//     ( ;   Tiled   y * width + x)
 	__m128 read(int index) const
 	{
 		assert(index >= 0 && index < (int)m_pixels.size());
@@ -47,7 +94,7 @@ class SOFTX_API TextureRGBA32F
 		int y = static_cast<int>(std::round(fv));
 		x = std::clamp(x, 0, m_width - 1);
 		y = std::clamp(y, 0, m_height - 1);
-		return m_pixels[y * m_width + x];
+		return m_pixels[texel_index(m_levels[0], x, y)];
 	}
 
 	float4 sample(float2 uv) const
@@ -56,16 +103,65 @@ class SOFTX_API TextureRGBA32F
 		return float4(color);
 	}
 
+	// -:  0 -  ,     ( 1x1).
+	//    0 ;       .
+	// pool -    (nullptr -   );      
+	void generate_mips(MipFilter filter = MipFilter::Box, ThreadPool* pool = nullptr);
+	int mip_count() const
+	{
+		return (int)m_levels.size();
+	}
+	int2 mip_size(int level) const
+	{
+		return int2(m_levels[level].Width, m_levels[level].Height);
+	}
+	__m128 read(int level, int2 coords) const
+	{
+		const MipLevel& mip = m_levels[level];
+		assert(coords.x >= 0 && coords.x < mip.Width && coords.y >= 0 && coords.y < mip.Height);
+		return m_pixels[texel_index(mip, coords.x, coords.y)];
+	}
+
+	TextureLayout layout() const
+	{
+		return m_layout;
+	}
+	//       
+	void set_layout(TextureLayout layout);
+
+	//     UV   ( CalculateLevelOfDetail  HLSL):
+	// log2       0  x  y ,   
+	float calc_lod(float2 ddx, float2 ddy) const;
+
+	//     lod      (),
+	//  clamp. lod   
+	float4 sample_level(float2 uv, float lod) const;
+	//       UV (PixelInput::Ddx / Ddy)
+	float4 sample_grad(float2 uv, float2 ddx, float2 ddy) const
+	{
+		return sample_level(uv, calc_lod(ddx, ddy));
+	}
+
+	//   UV   (SoA,   PixelQuadInput) -   SoA:
+	// rgba[0] -      ..
+	//     level
+	void sample4(__m128 u, __m128 v, TextureAddressMode address, __m128 rgba[4], int level = 0) const;
+	//          UV ( )
+	void sample4_grad(__m128 u, __m128 v, float2 ddx, float2 ddy, TextureAddressMode address, __m128 rgba[4]) const;
+
+	//    level (   )  SoA -  SamplerState
+	void fetch4(int level, __m128i x, __m128i y, __m128 rgba[4]) const;
+
 	//     ()
 	void stream_write(int2 coords, __m128 color)
 	{
 		assert(coords.x >= 0 && coords.x < m_width && coords.y >= 0 && coords.y < m_height);
-		int index = coords.y * m_width + coords.x;
+		size_t index = texel_index(m_levels[0], coords.x, coords.y);
 		//      16     std::vector<__m128>   C++17
 		_mm_stream_ps(reinterpret_cast<float*>(&m_pixels[index]), color);
 	}
 
-	//     (  )
+	//      (  )
 	void stream_write(int index, __m128 color)
 	{
 		assert(index >= 0 && index < (int)m_pixels.size());
@@ -82,6 +178,16 @@ class SOFTX_API TextureRGBA32F
 		return m_height;
 	}
 
+	//   0    (  Linear -   width() )
+	__m128* data()
+	{
+		return m_pixels.data();
+	}
+	const __m128* data() const
+	{
+		return m_pixels.data();
+	}
+
 	void saveToTGA(const TextureRGBA32F& tex, const char* filename)
 	{
 		int w = tex.width();
@@ -129,8 +235,175 @@ class SOFTX_API TextureRGBA32F
 	}
 
   private:
+	//     m_pixels,  0 - 
+	struct MipLevel
+	{
+		int Width, Height;
+		size_t Offset;
+	};
+
+	//      (Tiled     4x4)
+	static size_t level_size(int width, int height, TextureLayout layout)
+	{
+		if (layout == TextureLayout::Linear)
+			return (size_t)width * height;
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	}
+	static size_t texel_index(const MipLevel& level, int x, int y, TextureLayout layout)
+	{
+		if (layout == TextureLayout::Linear)
+			return level.Offset + (size_t)y * level.Width + x;
+		size_t block = (size_t)(y >> 2) * ((level.Width + 3) >> 2) + (x >> 2);
+		return level.Offset + block * 16 + ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2));
+	}
+	size_t texel_index(const MipLevel& level, int x, int y) const
+	{
+		return texel_index(level, x, y, m_layout);
+	}
+
+	__m128 sample_bilinear(const MipLevel& level, float2 uv) const;
+
 	int m_width, m_height;
+	TextureLayout m_layout;
 	std::vector<__m128> m_pixels;
+	std::vector<MipLevel> m_levels;
+};
+
+//    :   ,   TextureRGBA32F,   4-32   .
+//    float  ;    data()    TextureRGBA32F
+class SOFTX_API TextureCompact
+{
+  public:
+	//  ()   mipCount ; 0 -    1x1
+	TextureCompact(int2 size, TextureFormat format, int mipCount = 1);
+	//       -
+	TextureCompact(const TextureRGBA32F& source, TextureFormat format);
+
+	TextureFormat format() const
+	{
+		return m_format;
+	}
+	int width() const
+	{
+		return m_width;
+	}
+	int height() const
+	{
+		return m_height;
+	}
+	int mip_count() const
+	{
+		return (int)m_levels.size();
+	}
+	int2 mip_size(int level) const
+	{
+		return int2(m_levels[level].Width, m_levels[level].Height);
+	}
+	//     
+	size_t size_in_bytes() const
+	{
+		return m_data.size();
+	}
+
+	//    (,  BC   DDS):   row_pitch ,
+	//  BC  -   4x4
+	uint8_t* data(int level)
+	{
+		return m_data.data() + m_levels[level].Offset;
+	}
+	const uint8_t* data(int level) const
+	{
+		return m_data.data() + m_levels[level].Offset;
+	}
+	size_t row_pitch(int level) const
+	{
+		return m_levels[level].Pitch;
+	}
+
+	//  
+	float4 read(int level, int2 coords) const;
+
+	//  -   TextureRGBA32F
+	float calc_lod(float2 ddx, float2 ddy) const;
+	float4 sample_level(float2 uv, float lod) const;
+	float4 sample_grad(float2 uv, float2 ddx, float2 ddy) const
+	{
+		return sample_level(uv, calc_lod(ddx, ddy));
+	}
+	void sample4(__m128 u, __m128 v, TextureAddressMode address, __m128 rgba[4], int level = 0) const;
+	void sample4_grad(__m128 u, __m128 v, float2 ddx, float2 ddy, TextureAddressMode address, __m128 rgba[4]) const;
+
+	//     level  SoA -  SamplerState
+	void fetch4(int level, __m128i x, __m128i y, __m128 rgba[4]) const
+	{
+		fetch4(m_levels[level], x, y, rgba);
+	}
+
+  private:
+	struct MipLevel
+	{
+		int Width, Height;
+		size_t Offset;
+		size_t Pitch;
+	};
+
+	void allocate(int mipCount);
+	//     (   )  SoA
+	void fetch4(const MipLevel& level, __m128i x, __m128i y, __m128 rgba[4]) const;
+	//      
+	void sample4_lod(__m128 u, __m128 v, float lod, TextureAddressMode address, __m128 rgba[4]) const;
+
+	int m_width, m_height;
+	TextureFormat m_format;
+	std::vector<uint8_t> m_data;
+	std::vector<MipLevel> m_levels;
+};
+
+//   ( D3D11_SAMPLER_DESC)
+struct SamplerDesc
+{
+	TextureFilter Filter = TextureFilter::Trilinear;
+	TextureAddressMode AddressU = TextureAddressMode::Clamp;
+	TextureAddressMode AddressV = TextureAddressMode::Clamp;
+	float4 BorderColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+	float MipLodBias = 0.0f; //   ,   
+	float MinLod = 0.0f;	 //     
+	float MaxLod = FLT_MAX;
+};
+
+//   ,   DeviceContext::SetSampler.
+//            :
+//      
+class SOFTX_API SamplerState
+{
+  public:
+	SamplerState(const SamplerDesc& desc = SamplerDesc());
+
+	const SamplerDesc& desc() const
+	{
+		return m_desc;
+	}
+
+	//   UV  (SoA),   -   UV 
+	void sample4(const TextureRGBA32F& texture, __m128 u, __m128 v, float2 ddx, float2 ddy, __m128 rgba[4]) const;
+	void sample4(const TextureCompact& texture, __m128 u, __m128 v, float2 ddx, float2 ddy, __m128 rgba[4]) const;
+	//    ( SampleLevel  HLSL;     )
+	void sample4_level(const TextureRGBA32F& texture, __m128 u, __m128 v, float lod, __m128 rgba[4]) const;
+	void sample4_level(const TextureCompact& texture, __m128 u, __m128 v, float lod, __m128 rgba[4]) const;
+
+	//   (,  PixelProgram)
+	float4 sample(const TextureRGBA32F& texture, float2 uv, float2 ddx, float2 ddy) const;
+	float4 sample(const TextureCompact& texture, float2 uv, float2 ddx, float2 ddy) const;
+
+  private:
+	using SampleRGBA32F = void (*)(const TextureRGBA32F&, __m128, __m128, float, __m128, __m128*);
+	using SampleCompact = void (*)(const TextureCompact&, __m128, __m128, float, __m128, __m128*);
+
+	float clamp_lod(float lod) const;
+
+	SamplerDesc m_desc;
+	SampleRGBA32F m_sampleRGBA32F;
+	SampleCompact m_sampleCompact;
 };
 
 SOFTX_END
@@ -2,8 +2,11 @@
 #include <windows.h>
 #include <vector>
 #include <functional>
+#include <cstddef>
 
 #include "Math.h"
+#include "InputLayout.h"
+#include "Buffer.h"
 #include "LibInternal.h"
 
 SOFTX_BEGIN
@@ -43,75 +46,280 @@ struct VertexOutput
 	}
 };
 
+//  VertexInput  InputLayout: 0 - POSITION, 1 - COLOR, 2 - TEXCOORD
+inline InputLayout DefaultInputLayout()
+{
+	return InputLayout({{"POSITION", VertexFormat::Float3, (uint32_t)offsetof(VertexInput, Position)},
+						{"COLOR", VertexFormat::Float4, (uint32_t)offsetof(VertexInput, Color)},
+						{"TEXCOORD", VertexFormat::Float2, (uint32_t)offsetof(VertexInput, UV)}});
+}
+
+//    varying-  
+constexpr uint32_t MAX_VARYINGS = 32;
+
+//   DeviceContext::SetSampler
+constexpr uint32_t MAX_SAMPLERS = 8;
+class SamplerState;
+
+// ,    DeviceContext (MRT)
+constexpr uint32_t MAX_RENDER_TARGETS = 8;
+
+//     DeviceContext::SetViewports / SetScissorRects
+constexpr uint32_t MAX_VIEWPORTS = 16;
+
+//  4x:   D3D,       1/16 
+constexpr uint32_t MSAA_SAMPLE_COUNT = 4;
+constexpr int MSAA_SAMPLE_X16[MSAA_SAMPLE_COUNT] = {-2, 6, -6, 2};
+constexpr int MSAA_SAMPLE_Y16[MSAA_SAMPLE_COUNT] = {-6, -2, 2, 6};
+
+//  varyings,     (VertexOutput)    UV
+constexpr uint32_t VARYING_COLOR = 0;
+constexpr uint32_t VARYING_UV = 4;
+constexpr uint32_t LEGACY_VARYING_COUNT = 6;
+
+//     .
+//    ,    VaryingCount.
+struct Varyings
+{
+	float v[MAX_VARYINGS];
+	//   (DeviceContext::SetViewports),      .
+	//    -  0.       :
+	//     
+	uint32_t ViewportIndex;
+
+	void Set(uint32_t offset, float value)
+	{
+		v[offset] = value;
+	}
+	void Set(uint32_t offset, const float2& value)
+	{
+		v[offset] = value.x;
+		v[offset + 1] = value.y;
+	}
+	void Set(uint32_t offset, const float3& value)
+	{
+		v[offset] = value.x;
+		v[offset + 1] = value.y;
+		v[offset + 2] = value.z;
+	}
+	void Set(uint32_t offset, const float4& value)
+	{
+		_mm_storeu_ps(v + offset, value.v);
+	}
+
+	float Get(uint32_t offset) const
+	{
+		return v[offset];
+	}
+	float2 Get2(uint32_t offset) const
+	{
+		return float2(v[offset], v[offset + 1]);
+	}
+	float3 Get3(uint32_t offset) const
+	{
+		return float3(v[offset], v[offset + 1], v[offset + 2]);
+	}
+	float4 Get4(uint32_t offset) const
+	{
+		return float4(_mm_loadu_ps(v + offset));
+	}
+};
+
+//   .    2x2; Ddx  Ddy -  varyings
+//     ( ddx_coarse/ddy_coarse  HLSL):    ,
+//      .    VaryingCount 
+struct PixelInput
+{
+	float4 Position;	 //     
+	Varyings Attributes; //  varyings
+	Varyings Ddx;		 // d(varying)/dx
+	Varyings Ddy;		 // d(varying)/dy
+	const SamplerState* Samplers; // MAX_SAMPLERS ,   
+};
+
+//       2x2 (SoA):  i -  i ,
+// (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1)
+struct PixelQuadInput
+{
+	__m128 X, Y, Z;					 //     
+	__m128 Attributes[MAX_VARYINGS]; //  varyings,     helper lanes
+	Varyings Ddx;					 // ,    (  PixelInput)
+	Varyings Ddy;
+	int Mask; // ,    ;   - helper lanes
+	const SamplerState* Samplers; // MAX_SAMPLERS ,   
+};
+
+//    (SoA);    PixelQuadInput::Mask.
+// R, G, B, A -  0, Targets[i - 1] -  i ( R, G, B, A).
+//   1      ;       0
+struct PixelQuadOutput
+{
+	__m128 R, G, B, A;
+	__m128 Targets[MAX_RENDER_TARGETS - 1][4];
+
+	__m128* Target(uint32_t index)
+	{
+		return index == 0 ? &R : Targets[index - 1];
+	}
+	const __m128* Target(uint32_t index) const
+	{
+		return index == 0 ? &R : Targets[index - 1];
+	}
+};
+
+//        stride,   InputLayout.
+//    Buffer    :    ,
+//      ,   - 
 class VertexBuffer
 {
 private:
-	std::vector<VertexInput> m_data = {};
+	BufferPtr m_buffer = nullptr;
+	uint32_t m_stride = sizeof(VertexInput);
+
+	std::vector<uint8_t>& mutableData()
+	{
+		if (!m_buffer)
+			m_buffer = std::make_shared<Buffer>(BufferDesc(0, BufferUsage::Default, BIND_VERTEX_BUFFER), nullptr);
+		else if (m_buffer.use_count() > 1)
+			m_buffer = std::make_shared<Buffer>(*m_buffer);
+		return m_buffer->m_data;
+	}
+	void syncSize()
+	{
+		m_buffer->m_desc.ByteWidth = m_buffer->m_data.size();
+	}
 
 public:
 	VertexBuffer()
 	{
-		m_data = {};
 	}
 	VertexBuffer(const std::vector<VertexInput>& data)
 	{
-		m_data = data;
+		BufferDesc desc(data.size() * sizeof(VertexInput), BufferUsage::Default, BIND_VERTEX_BUFFER);
+		m_buffer = std::make_shared<Buffer>(desc, data.data());
 	}
-	size_t Size()
+	VertexBuffer(const void* data, size_t vertexCount, uint32_t stride)
+	{
+		BufferDesc desc(vertexCount * stride, BufferUsage::Default, BIND_VERTEX_BUFFER);
+		m_buffer = std::make_shared<Buffer>(desc, data);
+		m_stride = stride;
+	}
+	//      ( )
+	VertexBuffer(const BufferPtr& buffer, uint32_t stride)
+	{
+		m_buffer = buffer;
+		m_stride = stride;
+	}
+	size_t Size() const
 	{
-		return m_data.size();
+		return m_buffer ? m_buffer->Size() / m_stride : 0;
 	}
+	uint32_t Stride() const
+	{
+		return m_stride;
+	}
+	//     VertexInput (    stride == sizeof(VertexInput))
 	void Add(const VertexInput& Vertex)
 	{
-		m_data.push_back(Vertex);
+		Add(&Vertex);
+	}
+	//      (stride )
+	void Add(const void* Vertex)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(Vertex);
+		std::vector<uint8_t>& data = mutableData();
+		data.insert(data.end(), src, src + m_stride);
+		syncSize();
 	}
 	void Clear()
 	{
-		m_data.clear();
+		mutableData().clear();
+		syncSize();
 	}
 	bool IsEmpty() const
 	{
-		return m_data.empty();
+		return Size() == 0;
+	}
+	const uint8_t* Data() const
+	{
+		return m_buffer ? m_buffer->Data() : nullptr;
+	}
+	VertexInput GetByIndex(uint32_t index) const
+	{
+		VertexInput v;
+		std::memcpy((void*)&v, Data() + (size_t)index * m_stride, sizeof(VertexInput));
+		return v;
 	}
-	VertexInput GetByIndex(uint32_t index)
+	VertexBufferView View() const
 	{
-		return m_data[index];
+		return VertexBufferView(m_buffer, m_stride);
 	}
 };
 
+//  uint32_t,   ,   VertexBuffer ( Buffer +   )
 class IndexBuffer
 {
 private:
-	std::vector<uint32_t> m_data = {};
+	BufferPtr m_buffer = nullptr;
+
+	std::vector<uint8_t>& mutableData()
+	{
+		if (!m_buffer)
+			m_buffer = std::make_shared<Buffer>(BufferDesc(0, BufferUsage::Default, BIND_INDEX_BUFFER), nullptr);
+		else if (m_buffer.use_count() > 1)
+			m_buffer = std::make_shared<Buffer>(*m_buffer);
+		return m_buffer->m_data;
+	}
+	void syncSize()
+	{
+		m_buffer->m_desc.ByteWidth = m_buffer->m_data.size();
+	}
 
 public:
 	IndexBuffer()
 	{
-		m_data = {};
 	}
 	IndexBuffer(const std::vector<uint32_t>& data)
 	{
-		m_data = data;
+		BufferDesc desc(data.size() * sizeof(uint32_t), BufferUsage::Default, BIND_INDEX_BUFFER);
+		m_buffer = std::make_shared<Buffer>(desc, data.data());
 	}
-	size_t Size()
+	//      ( )
+	IndexBuffer(const BufferPtr& buffer)
+	{
+		m_buffer = buffer;
+	}
+	size_t Size() const
 	{
-		return m_data.size();
+		return m_buffer ? m_buffer->Size() / sizeof(uint32_t) : 0;
 	}
 	void Add(const uint32_t& Index)
 	{
-		m_data.push_back(Index);
+		const uint8_t* src = reinterpret_cast<const uint8_t*>(&Index);
+		std::vector<uint8_t>& data = mutableData();
+		data.insert(data.end(), src, src + sizeof(uint32_t));
+		syncSize();
 	}
 	void Clear()
 	{
-		m_data.clear();
+		mutableData().clear();
+		syncSize();
 	}
 	bool IsEmpty() const
 	{
-		return m_data.empty();
+		return Size() == 0;
+	}
+	const uint32_t* Data() const
+	{
+		return m_buffer ? reinterpret_cast<const uint32_t*>(m_buffer->Data()) : nullptr;
 	}
-	uint32_t GetByIndex(uint32_t index)
+	uint32_t GetByIndex(uint32_t index) const
 	{
-		return m_data[index];
+		return Data()[index];
+	}
+	IndexBufferView View() const
+	{
+		return IndexBufferView(m_buffer);
 	}
 };
 
@@ -132,6 +340,13 @@ public:
 		m_data = data;
 		m_size = size;
 	}
+	//    -:  Map(WriteDiscard)
+	//   ,   ConstantBuffer    
+	explicit ConstantBuffer(const BufferPtr& buffer)
+	{
+		m_data = buffer->Data();
+		m_size = buffer->Size();
+	}
 	size_t Size()
 	{
 		return m_size;
@@ -152,11 +367,24 @@ struct Viewport
 	{
 	}
 	Viewport(float x, float y, float width, float height, float minZ = 0, float maxZ = 1)
-		: pos(float2(x,y)), size(float2(width, height)), minZ(minZ), maxZ(maxZ)
+		: pos(float2(x,y)), size(int2((int)width, (int)height)), minZ(minZ), maxZ(maxZ)
 	{
 	}
 	Viewport(float2 _pos, float2 _size, float minZ = 0, float maxZ = 1)
-		: pos(_pos), size(_size), minZ(minZ), maxZ(maxZ)
+		: pos(_pos), size(int2((int)_size.x, (int)_size.y)), minZ(minZ), maxZ(maxZ)
+	{
+	}
+};
+
+//    ,       ( RECT  D3D)
+struct ScissorRect
+{
+	int Left, Top, Right, Bottom;
+
+	ScissorRect() : Left(0), Top(0), Right(0), Bottom(0)
+	{
+	}
+	ScissorRect(int left, int top, int right, int bottom) : Left(left), Top(top), Right(right), Bottom(bottom)
 	{
 	}
 };
@@ -172,9 +400,45 @@ struct Tile
 	}
 };
 
+//    SoA-:  ,
+//  varying- -   
+struct TransformedVertices
+{
+	std::vector<float4> Positions;
+	std::vector<float> Varyings; // [ * Count + ]
+	std::vector<uint8_t> ViewportIndex; //   ,     
+	uint32_t VaryingCount = 0;
+	uint32_t Count = 0;
+
+	void Resize(uint32_t count, uint32_t varyingCount)
+	{
+		Count = count;
+		VaryingCount = varyingCount;
+		Positions.resize(count);
+		Varyings.resize((size_t)count * varyingCount);
+		ViewportIndex.resize(count);
+	}
+	float* Varying(uint32_t component)
+	{
+		return Varyings.data() + (size_t)component * Count;
+	}
+	const float* Varying(uint32_t component) const
+	{
+		return Varyings.data() + (size_t)component * Count;
+	}
+};
+
 using PixelShader = std::function<float4(const VertexOutput& Input, ConstantBuffer ConstantBuffer)>;
 using VertexShader = std::function<VertexOutput(const VertexInput&, ConstantBuffer ConstantBuffer)>;
 
+//     (InputLayout)    varyings.
+//     clip space,  - .
+using VertexProgram = std::function<float4(const VertexAttributes& Input, Varyings& Output, ConstantBuffer ConstantBuffer)>;
+using PixelProgram = std::function<float4(const PixelInput& Input, ConstantBuffer ConstantBuffer)>;
+//  ,   2x2   (SIMD   )
+using QuadPixelProgram =
+	std::function<void(const PixelQuadInput& Input, PixelQuadOutput& Output, ConstantBuffer ConstantBuffer)>;
+
 enum class CullMode
 {
 	None,  //   
@@ -182,6 +446,201 @@ enum class CullMode
 	Back   //    ( )
 };
 
+//  :  ,  "z <func>   " ( D3D11_COMPARISON_FUNC).
+// LessEqual/Equal -     Z-prepass:      
+enum class DepthFunc
+{
+	Never,
+	Less, //  
+	Equal,
+	LessEqual,
+	Greater,
+	NotEqual,
+	GreaterEqual,
+	Always
+};
+
+inline bool DepthTestPasses(DepthFunc func, float z, float depth)
+{
+	switch (func)
+	{
+	case DepthFunc::Never: return false;
+	case DepthFunc::Less: return z < depth;
+	case DepthFunc::Equal: return z == depth;
+	case DepthFunc::LessEqual: return z <= depth;
+	case DepthFunc::Greater: return z > depth;
+	case DepthFunc::NotEqual: return z != depth;
+	case DepthFunc::GreaterEqual: return z >= depth;
+	default: return true;
+	}
+}
+
+//     
+enum class PrimitiveTopology
+{
+	TriangleList,  // (0 1 2) (3 4 5) ...
+	TriangleStrip, // (0 1 2) (2 1 3) (2 3 4) ...
+	TriangleFan	   // (0 1 2) (0 2 3) (0 3 4) ...
+};
+
+//   ( D3D11_BLEND): src -  , dest -   
+enum class BlendFactor
+{
+	Zero,
+	One,
+	SrcColor,
+	InvSrcColor,
+	SrcAlpha,
+	InvSrcAlpha,
+	DestAlpha,
+	InvDestAlpha,
+	DestColor,
+	InvDestColor,
+	SrcAlphaSat, // min(As, 1 - Ad)  , 1  
+	Constant,	 // BlendState::ConstantColor
+	InvConstant
+};
+
+enum class BlendOp
+{
+	Add,		 // src * SrcBlend + dest * DestBlend
+	Subtract,	 // src * SrcBlend - dest * DestBlend
+	RevSubtract, // dest * DestBlend - src * SrcBlend
+	Min,		 // min(src, dest),   
+	Max			 // max(src, dest)
+};
+
+// ,     ( )
+enum ColorWriteMask : uint8_t
+{
+	COLOR_WRITE_RED = 1 << 0,
+	COLOR_WRITE_GREEN = 1 << 1,
+	COLOR_WRITE_BLUE = 1 << 2,
+	COLOR_WRITE_ALPHA = 1 << 3,
+	COLOR_WRITE_ALL = 0xF
+};
+
+//      ( D3D11_RENDER_TARGET_BLEND_DESC)
+struct BlendState
+{
+	bool BlendEnable = false;
+	BlendFactor SrcBlend = BlendFactor::One;
+	BlendFactor DestBlend = BlendFactor::Zero;
+	BlendOp Op = BlendOp::Add;
+	BlendFactor SrcBlendAlpha = BlendFactor::One;
+	BlendFactor DestBlendAlpha = BlendFactor::Zero;
+	BlendOp OpAlpha = BlendOp::Add;
+	uint8_t WriteMask = COLOR_WRITE_ALL;
+	float4 ConstantColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	//  ;    Device    
+	static BlendState Opaque()
+	{
+		return BlendState();
+	}
+	//     : src + dest * (1 - As)
+	static BlendState Premultiplied()
+	{
+		return make(BlendFactor::One, BlendFactor::InvSrcAlpha, BlendFactor::One, BlendFactor::InvSrcAlpha);
+	}
+	//  :  src * As + dest * (1 - As),  As + Ad * (1 - As)
+	static BlendState AlphaBlend()
+	{
+		return make(BlendFactor::SrcAlpha, BlendFactor::InvSrcAlpha, BlendFactor::One, BlendFactor::InvSrcAlpha);
+	}
+	// src + dest
+	static BlendState Additive()
+	{
+		return make(BlendFactor::One, BlendFactor::One, BlendFactor::One, BlendFactor::One);
+	}
+
+  private:
+	static BlendState make(BlendFactor src, BlendFactor dest, BlendFactor srcAlpha, BlendFactor destAlpha)
+	{
+		BlendState state;
+		state.BlendEnable = true;
+		state.SrcBlend = src;
+		state.DestBlend = dest;
+		state.SrcBlendAlpha = srcAlpha;
+		state.DestBlendAlpha = destAlpha;
+		return state;
+	}
+};
+
+//     Device::DrawIndexedIndirect (   D3D11/12)
+struct DrawIndexedIndirectArgs
+{
+	uint32_t IndexCountPerInstance;
+	uint32_t InstanceCount;
+	uint32_t StartIndexLocation;
+	int32_t BaseVertexLocation; //    
+	uint32_t StartInstanceLocation;
+};
+
+//     
+struct BoundingBox
+{
+	float3 Min;
+	float3 Max;
+};
+
+struct BoundingSphere
+{
+	float3 Center;
+	float Radius;
+};
+
+enum class BoundsType
+{
+	None,  //   
+	Box,   // DrawBounds::Box
+	Sphere // DrawBounds::Sphere
+};
+
+//       .    
+//     ViewProjection * World (DeviceContext::SetViewProjection).
+//  DrawIndexedInstanced     
+struct DrawBounds
+{
+	BoundsType Type;
+	BoundingBox Box;
+	BoundingSphere Sphere;
+	float4x4 World;
+
+	DrawBounds() : Type(BoundsType::None), Box(), Sphere(), World()
+	{
+	}
+	DrawBounds(const BoundingBox& box, const float4x4& world)
+		: Type(BoundsType::Box), Box(box), Sphere(), World(world)
+	{
+	}
+	DrawBounds(const BoundingSphere& sphere, const float4x4& world)
+		: Type(BoundsType::Sphere), Box(), Sphere(sphere), World(world)
+	{
+	}
+};
+
+//  ,   Device::ResetStatistics
+struct PipelineStatistics
+{
+	uint64_t DrawsSubmitted;	 //   (DrawIndexed - , MultiDraw - drawCount)
+	uint64_t DrawsCulled;		 //       
+	uint64_t VerticesShaded;	 //   
+	uint64_t TrianglesAssembled; //    (  )
+	uint64_t MeshletsSubmitted;	 // ,   DrawMeshlets
+	uint64_t MeshletsCulled;	 //      
+	uint64_t DrawsPredicated;	 //     (DeviceContext::SetPredication)
+};
+
+//  :        
+// Device::BeginQuery  Device::EndQuery ( MSAA - ).  ,
+//     EndQuery. DrawFullScreenQuad,     
+struct OcclusionQuery
+{
+	uint64_t SamplesPassed = 0;
+	bool Active = false;
+};
+
 enum class FillMode
 {
 	Point,	   //  
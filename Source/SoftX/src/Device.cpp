@@ -1,5 +1,6 @@
 #include "pch.h"
 #include <SoftX/SoftX.h>  //   
+#include <algorithm>
 #include <atomic>
 
 SOFTX_BEGIN
@@ -9,10 +10,20 @@ Device::Device(const PresentParameters& params)
     : m_params(params)
     , m_backBuffer(params.BackBufferSize)
     , m_depthBuffer(params.BackBufferSize)
+    , m_varyingCount(0)
+    , m_depthTarget(&m_depthBuffer)
     , m_threadPool(std::make_unique<ThreadPool>(std::thread::hardware_concurrency()))
+    , m_uploadRing(1 << 20, 3) //   1 , 3   
+    , m_stats()
 {
 }
 
+Device::~Device()
+{
+    //     -     
+    retireDynamicBuffers(true);
+}
+
 // /  
 void Device::SetDeviceContext(const DeviceContext& ctx)
 {
@@ -24,34 +35,127 @@ DeviceContext Device::GetDeviceContext() const
     return m_DeviceContext;
 }
 
+BufferPtr Device::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	if (desc.ByteWidth == 0)
+		return nullptr;
+	if (desc.Usage == BufferUsage::Immutable && !initialData)
+		return nullptr;
+	return std::make_shared<Buffer>(desc, initialData);
+}
+
+void* Device::Map(const BufferPtr& buffer, MapMode mode)
+{
+	if (!buffer || buffer->m_desc.Usage != BufferUsage::Dynamic)
+		return nullptr;
+
+	if (mode == MapMode::WriteDiscard)
+	{
+		//  : draw,    ,    
+		buffer->m_version = static_cast<uint8_t*>(m_uploadRing.Allocate(buffer->Size()));
+		buffer->m_versionFrame = m_uploadRing.FrameIndex();
+		if (!buffer->m_tracked)
+		{
+			buffer->m_tracked = true;
+			m_dynamicBuffers.push_back(buffer);
+		}
+	}
+
+	buffer->m_mapped = true;
+	return buffer->m_version ? buffer->m_version : buffer->m_data.data();
+}
+
+void Device::Unmap(const BufferPtr& buffer)
+{
+	if (buffer)
+		buffer->m_mapped = false;
+}
+
+ConstantBuffer Device::UploadConstantBuffer(const void* data, size_t size)
+{
+	void* memory = m_uploadRing.Allocate(size);
+	std::memcpy(memory, data, size);
+	return ConstantBuffer(memory, size);
+}
+
+void Device::GenerateMips(TextureRGBA32F& texture, MipFilter filter)
+{
+    texture.generate_mips(filter, m_threadPool.get());
+}
+
+void Device::retireDynamicBuffers(bool all)
+{
+	//  FinishFrame     (next - framesInFlight)
+	uint64_t nextFrame = m_uploadRing.FrameIndex() + 1;
+	uint32_t framesInFlight = m_uploadRing.FramesInFlight();
+
+	size_t kept = 0;
+	for (size_t i = 0; i < m_dynamicBuffers.size(); ++i)
+	{
+		BufferPtr buffer = m_dynamicBuffers[i].lock();
+		if (!buffer)
+			continue;
+
+		if (all || buffer->m_versionFrame + framesInFlight <= nextFrame)
+		{
+			//    :      
+			std::memcpy(buffer->m_data.data(), buffer->m_version, buffer->Size());
+			buffer->m_version = nullptr;
+			buffer->m_tracked = false;
+			continue;
+		}
+		m_dynamicBuffers[kept++] = m_dynamicBuffers[i];
+	}
+	m_dynamicBuffers.resize(kept);
+}
+
 void Device::SetVertexBuffer(const VertexBuffer& buffer)
 {
 	m_DeviceContext.SetVertexBuffer(buffer);
 }
 
+void Device::SetVertexBuffer(const VertexBufferView& view)
+{
+	m_DeviceContext.SetVertexBuffer(view);
+}
+
 void Device::SetIndexBuffer(const IndexBuffer& buffer)
 {
 	m_DeviceContext.SetIndexBuffer(buffer);
 }
 
+void Device::SetIndexBuffer(const IndexBufferView& view)
+{
+	m_DeviceContext.SetIndexBuffer(view);
+}
+
+void Device::SetInstanceBuffer(const VertexBufferView& view)
+{
+	m_DeviceContext.SetInstanceBuffer(view);
+}
+
 void Device::SetConstantBuffer(ConstantBuffer cbuffer)
 {
 	m_DeviceContext.SetConstantBuffer(cbuffer);
 }
 
-//  :      backbuffer  
+//  :      backbuffer  
 void Device::Clear(const float4& color)
 {
-    IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
-    if (rt)
-        rt->clear(color);
-    else
+    uint32_t count = m_DeviceContext.GetRenderTargetCount();
+    for (uint32_t i = 0; i < count; ++i)
+        if (IRenderTarget* rt = m_DeviceContext.GetRenderTarget(i))
+            rt->clear(color);
+    if (count == 0)
         m_backBuffer.clear(color);
 }
 
 void Device::ClearDepth(float depth)
 {
-    m_depthBuffer.clear(depth);
+    DepthBuffer* target = m_DeviceContext.GetDepthTarget();
+    (target ? *target : m_depthBuffer).clear(depth);
+    m_depthClearValue = depth;
+    std::fill(m_sampleDepth.begin(), m_sampleDepth.end(), depth);
 }
 
 Framebuffer& Device::GetBackBuffer()
@@ -74,38 +178,97 @@ void Device::renderTileQuad(int tileIndex)
     int w = rt->width();
     int h = rt->height();
 
-    VertexOutput input = {};
-    auto ps = m_DeviceContext.GetPixelShader();
+    // UV   varyings  ,      (VARYING_UV)
+    PixelQuadInput input = {};
+    PixelQuadOutput output;
     auto cb = m_DeviceContext.GetConstantBuffer();
+    input.Samplers = m_DeviceContext.GetSamplers();
 
-    for (int y = tile.min.y; y <= tile.max.y; ++y)
+    float du = 1.0f / (w - 1), dv = 1.0f / (h - 1);
+    input.Ddx.Set(VARYING_UV, float2(du, 0.0f));
+    input.Ddy.Set(VARYING_UV, float2(0.0f, dv));
+    const __m128 laneX = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f);
+    const __m128 laneY = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+
+    //           
+    //         
+    int x0 = tile.min.x & ~1;
+    int spanWidth = tile.max.x - x0 + 2;
+    std::vector<float4> rows;
+    if (!m_blendFunction)
+        rows.resize((size_t)spanWidth * 2 * m_renderTargetCount);
+
+    //  2x2   ,     - helper lanes
+    for (int y = tile.min.y & ~1; y <= tile.max.y; y += 2)
     {
-        float v = (float)y / (h - 1);
-        for (int x = tile.min.x; x <= tile.max.x; ++x)
+        input.Y = _mm_add_ps(_mm_set1_ps((float)y), laneY);
+        input.Attributes[VARYING_UV + 1] = _mm_div_ps(input.Y, _mm_set1_ps((float)(h - 1)));
+        for (int x = tile.min.x & ~1; x <= tile.max.x; x += 2)
+        {
+            input.X = _mm_add_ps(_mm_set1_ps((float)x), laneX);
+            input.Attributes[VARYING_UV] = _mm_div_ps(input.X, _mm_set1_ps((float)(w - 1)));
+            input.Mask = 0xF;
+            if (x < tile.min.x) input.Mask &= 0xA;
+            if (x + 1 > tile.max.x) input.Mask &= 0x5;
+            if (y < tile.min.y) input.Mask &= 0xC;
+            if (y + 1 > tile.max.y) input.Mask &= 0x3;
+
+            m_pixelProgram(input, output, cb);
+            if (m_blendFunction)
+            {
+                writeQuad(output, input.Mask, x, y);
+                continue;
+            }
+            for (uint32_t target = 0; target < m_renderTargetCount; ++target)
+            {
+                const __m128* c = output.Target(target);
+                __m128 c0 = c[0], c1 = c[1], c2 = c[2], c3 = c[3];
+                _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+                float4* row = &rows[(size_t)target * spanWidth * 2 + x - x0];
+                row[0] = c0;
+                row[1] = c1;
+                row[spanWidth] = c2;
+                row[spanWidth + 1] = c3;
+            }
+        }
+        if (m_blendFunction)
+            continue;
+
+        int count = tile.max.x - tile.min.x + 1;
+        for (uint32_t target = 0; target < m_renderTargetCount; ++target)
         {
-            float u = (float)x / (w - 1);
-            input.UV = float2(u, v);
-            float4 color = ps(input, cb);
-            rt->set_pixel(int2(x, y), color);
+            const float4* row = &rows[(size_t)target * spanWidth * 2 + tile.min.x - x0];
+            if (y >= tile.min.y)
+                m_renderTargets[target]->write_span(tile.min.x, y, count, row);
+            if (y + 1 <= tile.max.y)
+                m_renderTargets[target]->write_span(tile.min.x, y + 1, count, row + spanWidth);
         }
     }
 }
 
 void Device::DrawFullScreenQuad()
 {
-    auto ps = m_DeviceContext.GetPixelShader();
-    if (!ps) return;
+    if (isPredicatedOff())
+    {
+        ++m_stats.DrawsPredicated;
+        return;
+    }
+    m_pixelProgram = m_DeviceContext.GetQuadPixelProgram();
+    if (!m_pixelProgram) return;
+    setupOutputMerger();
 
     IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
     if (!rt) rt = &m_backBuffer;  //    backbuffer
 
-    int w = rt->width();
-    int h = rt->height();
-
-    //      
-    buildTiles(w, h); //  m_tileSize  ?    
-    //  buildTiles,      
-    //    ,       
+    //         0
+    int2 areaMin(0, 0), areaMax = rt->size() - int2(1, 1);
+    if (m_DeviceContext.GetScissorEnable() && m_DeviceContext.GetScissorRectCount() > 0)
+    {
+        const ScissorRect& rect = m_DeviceContext.GetScissorRect(0);
+        areaMin = max(areaMin, int2(rect.Left, rect.Top));
+        areaMax = min(areaMax, int2(rect.Right - 1, rect.Bottom - 1));
+    }
+    buildTiles(areaMin, areaMax);
 
     int numTiles = (int)m_tiles.size();
     std::atomic<int> tileIndex(0);
@@ -129,6 +292,96 @@ void Device::DrawFullScreenQuad()
 
 void Device::DrawIndexed(uint32_t indexCount, uint32_t startIndex)
 {
+    DrawIndexedInstanced(indexCount, 1, startIndex, 0, 0);
+}
+
+void Device::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex,
+                                  int32_t baseVertex, uint32_t startInstance)
+{
+    DrawIndexedIndirectArgs args = {indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance};
+    drawIndexedBatch(&args, 1, nullptr);
+}
+
+void Device::DrawIndexedIndirect(const BufferPtr& args, uint32_t offset)
+{
+    MultiDrawIndexedIndirect(args, offset, 1, sizeof(DrawIndexedIndirectArgs));
+}
+
+void Device::MultiDrawIndexedIndirect(const BufferPtr& args, uint32_t offset, uint32_t drawCount, uint32_t stride,
+                                      const DrawBounds* bounds)
+{
+    if (drawCount == 0)
+        return;
+    if (!args || !(args->GetDesc().BindFlags & BIND_INDIRECT_ARGS))
+    {
+        printf("Argument buffer is not bound as BIND_INDIRECT_ARGS ");
+        return;
+    }
+    if (stride < sizeof(DrawIndexedIndirectArgs) ||
+        (size_t)offset + (size_t)(drawCount - 1) * stride + sizeof(DrawIndexedIndirectArgs) > args->Size())
+    {
+        printf("Argument buffer is too small ");
+        return;
+    }
+
+    //  :      
+    const uint8_t* data = args->Data() + offset;
+    m_indirectArgs.resize(drawCount);
+    for (uint32_t i = 0; i < drawCount; ++i)
+        std::memcpy(&m_indirectArgs[i], data + (size_t)i * stride, sizeof(DrawIndexedIndirectArgs));
+
+    drawIndexedBatch(m_indirectArgs.data(), drawCount, bounds);
+}
+
+const PipelineStatistics& Device::GetStatistics() const
+{
+    return m_stats;
+}
+
+void Device::ResetStatistics()
+{
+    m_stats = PipelineStatistics();
+}
+
+void Device::BeginQuery(OcclusionQuery& query)
+{
+    if (query.Active)
+    {
+        printf("Query is already active ");
+        return;
+    }
+    query.SamplesPassed = 0;
+    query.Active = true;
+    m_activeQueries.push_back(&query);
+}
+
+void Device::EndQuery(OcclusionQuery& query)
+{
+    auto it = std::find(m_activeQueries.begin(), m_activeQueries.end(), &query);
+    if (it == m_activeQueries.end())
+    {
+        printf("Query is not active ");
+        return;
+    }
+    m_activeQueries.erase(it);
+    query.Active = false;
+}
+
+void Device::drawIndexedBatch(const DrawIndexedIndirectArgs* draws, uint32_t drawCount, const DrawBounds* bounds)
+{
+    //        -        
+    m_stats.DrawsSubmitted += drawCount;
+    if (isPredicatedOff())
+    {
+        m_stats.DrawsPredicated += drawCount;
+        return;
+    }
+    if (isCulled(m_DeviceContext.GetDrawBounds()))
+    {
+        m_stats.DrawsCulled += drawCount;
+        return;
+    }
+
 	std::string err;
 	bool rslt = m_DeviceContext.Validate(&err);
 	if (!rslt)
@@ -137,89 +390,436 @@ void Device::DrawIndexed(uint32_t indexCount, uint32_t startIndex)
 		return;
 	}
 
-    //      
-    auto vs = m_DeviceContext.GetVertexShader();
-    auto ps = m_DeviceContext.GetPixelShader();
-    auto vb = m_DeviceContext.GetVertexBuffer();
-    auto ib = m_DeviceContext.GetIndexBuffer();
-    auto cb = m_DeviceContext.GetConstantBuffer();
-    auto rt = m_DeviceContext.GetRenderTarget();
-    auto fillMode = m_DeviceContext.GetFillMode();
-    auto cullMode = m_DeviceContext.GetCullMode();
-    auto tiledEnabled = m_DeviceContext.GetTileRenderingState();
-    auto tileSize = m_DeviceContext.GetTileSize();  //    
+    captureDrawState();
+
+    //    : ,    ,    
+    m_preparedDraws.clear();
+    m_usedVertices.clear();
+    m_instanceTriangles.clear();
+    //     ,    
+    size_t vertexCount = m_DeviceContext.GetVertexBufferView().VertexCount();
+    if (m_vertexSlots.size() < vertexCount)
+        m_vertexSlots.resize(vertexCount, ~0u);
+    for (uint32_t i = 0; i < drawCount; ++i)
+    {
+        if (bounds && isCulled(bounds[i]))
+        {
+            ++m_stats.DrawsCulled;
+            continue;
+        }
+        prepareDraw(draws[i]);
+    }
+    submitPreparedDraws();
+}
+
+void Device::DrawMeshlets(const MeshletMesh& mesh, const float4x4& world, uint32_t cullFlags)
+{
+    m_stats.DrawsSubmitted += 1;
+    if (isPredicatedOff())
+    {
+        m_stats.DrawsPredicated += 1;
+        return;
+    }
+    if (isCulled(m_DeviceContext.GetDrawBounds()))
+    {
+        m_stats.DrawsCulled += 1;
+        return;
+    }
+
+	std::string err;
+	bool rslt = m_DeviceContext.Validate(&err, false);
+	if (!rslt)
+	{
+		printf("%s", err.c_str());
+		return;
+	}
+
+    captureDrawState();
+
+    //     ;    -   
+    m_stats.MeshletsSubmitted += mesh.Meshlets.size();
+    cullMeshlets(mesh, world, cullFlags);
+
+    m_preparedDraws.clear();
+    m_usedVertices.clear();
+    m_instanceTriangles.clear();
+    for (size_t i = 0; i < mesh.Meshlets.size(); ++i)
+    {
+        if (!m_meshletVisible[i])
+        {
+            ++m_stats.MeshletsCulled;
+            continue;
+        }
+        prepareMeshlet(mesh, mesh.Meshlets[i]);
+    }
+    submitPreparedDraws();
+}
+
+void Device::captureDrawState()
+{
+    //           
+    m_vertexProgram = m_DeviceContext.GetVertexProgram();
+    m_inputLayout = m_DeviceContext.GetInputLayout();
+    //     varyings,    
+    m_pixelProgram = m_DeviceContext.GetQuadPixelProgram();
+    m_varyingCount = std::min(m_DeviceContext.GetVertexVaryingCount(), m_DeviceContext.GetPixelVaryingCount());
+    m_depthTarget = m_DeviceContext.GetDepthTarget() ? m_DeviceContext.GetDepthTarget() : &m_depthBuffer;
+    m_depthFunc = m_DeviceContext.GetDepthFunc();
+    m_depthWrite = m_DeviceContext.GetDepthWrite();
+    m_depthOnly = m_DeviceContext.GetRenderTargetCount() == 0 && !m_pixelProgram;
+    if (m_depthOnly)
+    {
+        //    -     
+        m_varyingCount = 0;
+        m_targetSize = m_depthTarget->size();
+    }
+    else
+        m_targetSize = m_DeviceContext.GetRenderTarget()->size();
+    setupClipRects();
+    setupOutputMerger();
+}
+
+void Device::setupClipRects()
+{
+    m_viewportCount = m_DeviceContext.GetViewportCount();
+    bool scissor = m_DeviceContext.GetScissorEnable();
+    int2 targetMax = m_targetSize - int2(1, 1);
+    m_clipTriangles = false;
+    for (uint32_t i = 0; i < m_viewportCount; ++i)
+    {
+        // ,     
+        Viewport vp = m_DeviceContext.GetViewport(i);
+        int2 rectMin((int)std::ceil(vp.pos.x - 0.5f), (int)std::ceil(vp.pos.y - 0.5f));
+        int2 rectMax((int)std::ceil(vp.pos.x + vp.size.x - 0.5f) - 1, (int)std::ceil(vp.pos.y + vp.size.y - 0.5f) - 1);
+        if (scissor)
+        {
+            const ScissorRect& rect = m_DeviceContext.GetScissorRect(i);
+            rectMin = max(rectMin, int2(rect.Left, rect.Top));
+            rectMax = min(rectMax, int2(rect.Right - 1, rect.Bottom - 1));
+        }
+        m_clipMin[i] = max(rectMin, int2(0, 0));
+        m_clipMax[i] = min(rectMax, targetMax);
+        if (m_clipMin[i] != int2(0, 0) || m_clipMax[i] != targetMax)
+            m_clipTriangles = true;
+    }
+}
+
+void Device::submitPreparedDraws()
+{
+    //    :   -  
+    //  ,   ;      
+    m_batch.clear();
+    uint32_t batchVertices = 0;
+    for (uint32_t d = 0; d < (uint32_t)m_preparedDraws.size(); ++d)
+    {
+        const PreparedDraw& draw = m_preparedDraws[d];
+        uint32_t first = 0;
+        while (first < draw.InstanceCount)
+        {
+            uint32_t room = (MAX_BATCH_VERTICES - std::min(batchVertices, MAX_BATCH_VERTICES)) / draw.VertexCount;
+            if (room == 0 && !m_batch.empty())
+            {
+                flushBatch(batchVertices);
+                batchVertices = 0;
+                continue;
+            }
+            uint32_t count = std::min(std::max(room, 1u), draw.InstanceCount - first);
+            m_batch.push_back({d, first, count, batchVertices});
+            batchVertices += count * draw.VertexCount;
+            first += count;
+        }
+    }
+    if (!m_batch.empty())
+        flushBatch(batchVertices);
+}
+
+void Device::prepareDraw(const DrawIndexedIndirectArgs& args)
+{
+    const IndexBufferView& ib = m_DeviceContext.GetIndexBufferView();
+    const VertexBufferView& instances = m_DeviceContext.GetInstanceBufferView();
+    uint32_t vertexCount = (uint32_t)m_DeviceContext.GetVertexBufferView().VertexCount();
+
+    if (args.InstanceCount == 0 || args.IndexCountPerInstance == 0)
+        return;
+    if ((size_t)args.StartIndexLocation + args.IndexCountPerInstance > ib.IndexCount())
+    {
+        printf("Index range is out of bounds ");
+        return;
+    }
+    if (m_inputLayout.HasPerInstanceElements() &&
+        (size_t)args.StartInstanceLocation + args.InstanceCount > instances.VertexCount())
+    {
+        printf("Instance buffer is too small ");
+        return;
+    }
+
+    //      uint32_t (16- )
+    const uint32_t* indices = fetchIndices(ib, args.StartIndexLocation, args.IndexCountPerInstance);
+    bool restart = m_DeviceContext.GetPrimitiveRestart();
+    uint32_t restartIndex = ib.RestartIndex();
+
+    //     ;     
+    uint32_t firstVertex = (uint32_t)m_usedVertices.size();
+    bool inRange = true;
+    for (uint32_t i = 0; i < args.IndexCountPerInstance; ++i)
+    {
+        if (restart && indices[i] == restartIndex)
+            continue;
+        uint32_t idx = indices[i] + args.BaseVertexLocation;
+        if (idx >= vertexCount)
+        {
+            inRange = false;
+            break;
+        }
+        if (m_vertexSlots[idx] == ~0u)
+        {
+            m_vertexSlots[idx] = (uint32_t)m_usedVertices.size() - firstVertex;
+            m_usedVertices.push_back(idx);
+        }
+    }
+
+    uint32_t firstTriangle = (uint32_t)m_instanceTriangles.size();
+    if (inRange)
+    {
+        //            
+        assembleTriangles(indices, args.IndexCountPerInstance, m_DeviceContext.GetPrimitiveTopology(), restart,
+                          restartIndex);
+        for (const int3& tri : m_triangles)
+        {
+            m_instanceTriangles.push_back({(int)m_vertexSlots[tri.x + args.BaseVertexLocation],
+                                           (int)m_vertexSlots[tri.y + args.BaseVertexLocation],
+                                           (int)m_vertexSlots[tri.z + args.BaseVertexLocation]});
+        }
+    }
+    else
+    {
+        printf("Vertex index is out of bounds ");
+    }
+
+    //      
+    uint32_t usedCount = (uint32_t)m_usedVertices.size() - firstVertex;
+    for (uint32_t i = 0; i < usedCount; ++i)
+        m_vertexSlots[m_usedVertices[firstVertex + i]] = ~0u;
+
+    uint32_t triangleCount = (uint32_t)m_instanceTriangles.size() - firstTriangle;
+    if (!inRange || triangleCount == 0)
+    {
+        m_usedVertices.resize(firstVertex);
+        return;
+    }
 
-    //   
-    m_transformedVerts.clear();
+    m_preparedDraws.push_back({firstVertex, usedCount, firstTriangle, triangleCount, args.InstanceCount,
+                               args.StartInstanceLocation});
+}
+
+void Device::prepareMeshlet(const MeshletMesh& mesh, const Meshlet& meshlet)
+{
+    const VertexBufferView& instances = m_DeviceContext.GetInstanceBufferView();
+    uint32_t vertexCount = m_DeviceContext.GetVertexBufferView().VertexCount();
+
+    if (meshlet.TriangleCount == 0)
+        return;
+    if ((size_t)meshlet.VertexOffset + meshlet.VertexCount > mesh.Vertices.size() ||
+        (size_t)meshlet.TriangleOffset + (size_t)meshlet.TriangleCount * 3 > mesh.Triangles.size())
+    {
+        printf("Meshlet range is out of bounds ");
+        return;
+    }
+    if (m_inputLayout.HasPerInstanceElements() && instances.VertexCount() == 0)
+    {
+        printf("Instance buffer is too small ");
+        return;
+    }
+
+    //    ,      
+    const uint32_t* vertices = mesh.Vertices.data() + meshlet.VertexOffset;
+    for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+    {
+        if (vertices[i] >= vertexCount)
+        {
+            printf("Vertex index is out of bounds ");
+            return;
+        }
+    }
+
+    uint32_t firstVertex = (uint32_t)m_usedVertices.size();
+    uint32_t firstTriangle = (uint32_t)m_instanceTriangles.size();
+    m_usedVertices.insert(m_usedVertices.end(), vertices, vertices + meshlet.VertexCount);
+    const uint8_t* triangles = mesh.Triangles.data() + meshlet.TriangleOffset;
+    for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+        m_instanceTriangles.push_back({triangles[t * 3 + 0], triangles[t * 3 + 1], triangles[t * 3 + 2]});
+
+    m_preparedDraws.push_back({firstVertex, meshlet.VertexCount, firstTriangle, meshlet.TriangleCount, 1, 0});
+}
+
+void Device::flushBatch(uint32_t vertexCount)
+{
+    m_transformedVerts.Resize(vertexCount, m_varyingCount);
+    transformVertices();
+    m_stats.VerticesShaded += vertexCount;
+
+    //          
     m_triangles.clear();
+    for (const BatchItem& item : m_batch)
+    {
+        const PreparedDraw& draw = m_preparedDraws[item.Draw];
+        const int3* triangles = m_instanceTriangles.data() + draw.FirstTriangle;
+        for (uint32_t i = 0; i < item.InstanceCount; ++i)
+        {
+            int offset = (int)(item.FirstTransformed + i * draw.VertexCount);
+            for (uint32_t t = 0; t < draw.TriangleCount; ++t)
+                m_triangles.push_back({triangles[t].x + offset, triangles[t].y + offset, triangles[t].z + offset});
+        }
+    }
+
+    m_stats.TrianglesAssembled += m_triangles.size();
+    drawTriangles();
+    m_batch.clear();
+}
+
+void Device::transformVertices()
+{
+    const VertexBufferView& vb = m_DeviceContext.GetVertexBufferView();
+    const VertexBufferView& instances = m_DeviceContext.GetInstanceBufferView();
+    ConstantBuffer cb = m_DeviceContext.GetConstantBuffer();
+
+    const uint8_t* vertexData = vb.Data();
+    uint32_t stride = vb.Stride;
+    const uint8_t* instanceData = m_inputLayout.HasPerInstanceElements() ? instances.Data() : nullptr;
+    uint32_t instanceStride = instances.Stride;
+    uint32_t total = m_transformedVerts.Count;
+    float* varyings = m_transformedVerts.Varyings.data();
+
+    //  t   -   t % VertexCount  FirstInstance + t / VertexCount
+    auto transformRange = [&](const BatchItem& item, uint32_t begin, uint32_t end) {
+        const PreparedDraw& draw = m_preparedDraws[item.Draw];
+        const uint32_t* used = m_usedVertices.data() + draw.FirstVertex;
+        Varyings out;
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            uint32_t instance = item.FirstInstance + t / draw.VertexCount;
+            uint32_t idx = used[t % draw.VertexCount];
+            const uint8_t* instanceAttributes =
+                instanceData ? instanceData + (size_t)(draw.StartInstance + instance) * instanceStride : nullptr;
+
+            VertexAttributes in(vertexData + (size_t)idx * stride, m_inputLayout, idx, instanceAttributes, instance);
+            out.ViewportIndex = 0;
+            float4 clipPos = m_vertexProgram(in, out, cb);
+            uint32_t dst = item.FirstTransformed + t;
+            uint32_t viewport = out.ViewportIndex < m_viewportCount ? out.ViewportIndex : 0;
+            m_transformedVerts.Positions[dst] = ClipToScreen(clipPos, viewport);
+            m_transformedVerts.ViewportIndex[dst] = (uint8_t)viewport;
+
+            //  varyings  SoA- 
+            for (uint32_t k = 0; k < m_varyingCount; ++k)
+                varyings[(size_t)k * total + dst] = out.v[k];
+        }
+    };
+
+    //       
+    uint32_t numThreads = (uint32_t)m_threadPool->threadCount();
+    if (total < PARALLEL_VERTEX_THRESHOLD || numThreads < 2)
+    {
+        for (const BatchItem& item : m_batch)
+            transformRange(item, 0, item.InstanceCount * m_preparedDraws[item.Draw].VertexCount);
+        return;
+    }
 
-    //   ,    
-    std::vector<bool> vertexProcessed(vb.Size(), false);
-    for (uint32_t i = startIndex; i < startIndex + indexCount; ++i)
+    uint32_t chunk = (total + numThreads * 4 - 1) / (numThreads * 4);
+    for (const BatchItem& item : m_batch)
     {
-        uint32_t idx = ib.GetByIndex(i);
-        if (!vertexProcessed[idx])
+        uint32_t count = item.InstanceCount * m_preparedDraws[item.Draw].VertexCount;
+        for (uint32_t begin = 0; begin < count; begin += chunk)
         {
-            vertexProcessed[idx] = true;
-            VertexOutput out = vs(vb.GetByIndex(idx), cb);
-            out.Position = ClipToScreen(out.Position); //   viewport  ? ClipToScreen   viewport  
-            if (m_transformedVerts.size() <= idx)
-                m_transformedVerts.resize(idx + 1);
-            m_transformedVerts[idx] = out;
+            uint32_t end = std::min(begin + chunk, count);
+            const BatchItem* work = &item;
+            m_threadPool->enqueue([&transformRange, work, begin, end]() { transformRange(*work, begin, end); });
         }
     }
+    m_threadPool->wait();
+}
+
+void Device::drawTriangles()
+{
+    auto fillMode = m_DeviceContext.GetFillMode();
+    auto tiledEnabled = m_DeviceContext.GetTileRenderingState();
 
-    //  
-    for (uint32_t i = startIndex; i < startIndex + indexCount; i += 3)
+    //       :    
+    //         
+    if (m_viewportCount > 1)
     {
-        if (i + 2 >= startIndex + indexCount) break;
-        uint32_t i0 = ib.GetByIndex(i);
-        uint32_t i1 = ib.GetByIndex(i + 1);
-        uint32_t i2 = ib.GetByIndex(i + 2);
-        m_triangles.push_back({(int)i0, (int)i1, (int)i2});
+        const uint8_t* viewports = m_transformedVerts.ViewportIndex.data();
+        m_triangles.erase(std::remove_if(m_triangles.begin(), m_triangles.end(),
+                                         [viewports](const int3& tri) {
+                                             return viewports[tri.x] != viewports[tri.y] ||
+                                                    viewports[tri.x] != viewports[tri.z];
+                                         }),
+                          m_triangles.end());
     }
 
     if (fillMode == FillMode::Solid)
     {
         if (tiledEnabled)
         {
-            buildTiles(rt->width(), rt->height()); //   
-            //  buildTiles    tileSize  
-            //     ,   m_tileSize,   
+            //  -     
+            int2 areaMin = m_clipMin[0], areaMax = m_clipMax[0];
+            for (uint32_t i = 1; i < m_viewportCount; ++i)
+            {
+                areaMin = min(areaMin, m_clipMin[i]);
+                areaMax = max(areaMax, m_clipMax[i]);
+            }
+            buildTiles(areaMin, areaMax);
             binTriangles(m_transformedVerts, m_triangles);
             renderTilesMultithreaded();
+            if (!m_activeQueries.empty())
+            {
+                uint64_t samples = 0;
+                for (const TileSamples& tile : m_tileSamples)
+                    samples += tile.Passed;
+                for (OcclusionQuery* query : m_activeQueries)
+                    query->SamplesPassed += samples;
+            }
         }
         else
         {
             //  
+            uint64_t samples = 0;
             for (const auto& tri : m_triangles)
             {
-                RasterizeTriangleSSE(m_transformedVerts[tri.x], m_transformedVerts[tri.y], m_transformedVerts[tri.z]);
+                samples += RasterizeTriangleSSE(tri);
             }
+            for (OcclusionQuery* query : m_activeQueries)
+                query->SamplesPassed += samples;
         }
     }
     else if (fillMode == FillMode::Wireframe)
     {
+        // и     ,    
         float4 wireColor(1.0f, 1.0f, 1.0f, 1.0f);
         for (const auto& tri : m_triangles)
         {
-            const auto& v0 = m_transformedVerts[tri.x];
-            const auto& v1 = m_transformedVerts[tri.y];
-            const auto& v2 = m_transformedVerts[tri.z];
-            DrawLine((int)round(v0.Position.x), (int)round(v0.Position.y),
-                     (int)round(v1.Position.x), (int)round(v1.Position.y),
-                     v0.Position.z, v1.Position.z, wireColor);
-            DrawLine((int)round(v1.Position.x), (int)round(v1.Position.y),
-                     (int)round(v2.Position.x), (int)round(v2.Position.y),
-                     v1.Position.z, v2.Position.z, wireColor);
-            DrawLine((int)round(v2.Position.x), (int)round(v2.Position.y),
-                     (int)round(v0.Position.x), (int)round(v0.Position.y),
-                     v2.Position.z, v0.Position.z, wireColor);
+            uint32_t viewport = triangleViewport(tri);
+            const int2& clipMin = m_clipMin[viewport];
+            const int2& clipMax = m_clipMax[viewport];
+            const float4& p0 = m_transformedVerts.Positions[tri.x];
+            const float4& p1 = m_transformedVerts.Positions[tri.y];
+            const float4& p2 = m_transformedVerts.Positions[tri.z];
+            drawLine((int)round(p0.x), (int)round(p0.y),
+                     (int)round(p1.x), (int)round(p1.y),
+                     p0.z, p1.z, wireColor, clipMin, clipMax);
+            drawLine((int)round(p1.x), (int)round(p1.y),
+                     (int)round(p2.x), (int)round(p2.y),
+                     p1.z, p2.z, wireColor, clipMin, clipMax);
+            drawLine((int)round(p2.x), (int)round(p2.y),
+                     (int)round(p0.x), (int)round(p0.y),
+                     p2.z, p0.z, wireColor, clipMin, clipMax);
         }
     }
     else if (fillMode == FillMode::Point)
     {
-        std::vector<bool> drawn(m_transformedVerts.size(), false);
+        //   -  4 varyings (VARYING_COLOR),    
+        bool hasColor = m_varyingCount >= VARYING_COLOR + 4;
+        std::vector<bool> drawn(m_transformedVerts.Count, false);
         for (const auto& tri : m_triangles)
         {
             for (int idx : {tri.x, tri.y, tri.z})
@@ -227,23 +827,116 @@ void Device::DrawIndexed(uint32_t indexCount, uint32_t startIndex)
                 if (!drawn[idx])
                 {
                     drawn[idx] = true;
-                    const auto& v = m_transformedVerts[idx];
-                    DrawPoint((int)round(v.Position.x), (int)round(v.Position.y), v.Position.z, v.Color);
+                    const float4& p = m_transformedVerts.Positions[idx];
+                    int x = (int)round(p.x), y = (int)round(p.y);
+                    uint32_t viewport = triangleViewport(tri);
+                    if (x < m_clipMin[viewport].x || x > m_clipMax[viewport].x || y < m_clipMin[viewport].y ||
+                        y > m_clipMax[viewport].y)
+                        continue;
+                    float4 color(1.0f, 1.0f, 1.0f, 1.0f);
+                    if (hasColor)
+                    {
+                        color = float4(m_transformedVerts.Varying(VARYING_COLOR)[idx], m_transformedVerts.Varying(VARYING_COLOR + 1)[idx],
+                                       m_transformedVerts.Varying(VARYING_COLOR + 2)[idx], m_transformedVerts.Varying(VARYING_COLOR + 3)[idx]);
+                    }
+                    DrawPoint(x, y, p.z, color);
                 }
             }
         }
     }
 }
 
+const uint32_t* Device::fetchIndices(const IndexBufferView& ib, uint32_t startIndex, uint32_t indexCount)
+{
+    if (ib.Format == IndexFormat::UInt32)
+        return reinterpret_cast<const uint32_t*>(ib.Data()) + startIndex;
+
+    // 16-     8   
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(ib.Data()) + startIndex;
+    m_indices.resize(indexCount);
+    uint32_t* dst = m_indices.data();
+
+    __m128i zero = _mm_setzero_si128();
+    uint32_t i = 0;
+    for (; i + 8 <= indexCount; i += 8)
+    {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(packed, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(packed, zero));
+    }
+    for (; i < indexCount; ++i)
+        dst[i] = src[i];
+
+    return dst;
+}
+
+void Device::assembleTriangles(const uint32_t* indices, uint32_t indexCount, PrimitiveTopology topology, bool restart, uint32_t restartIndex)
+{
+    m_triangles.clear();
+
+    if (topology == PrimitiveTopology::TriangleList)
+    {
+        for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            uint32_t i0 = indices[i];
+            uint32_t i1 = indices[i + 1];
+            uint32_t i2 = indices[i + 2];
+            if (restart && (i0 == restartIndex || i1 == restartIndex || i2 == restartIndex))
+                continue;
+            m_triangles.push_back({(int)i0, (int)i1, (int)i2});
+        }
+        return;
+    }
+
+    // Strip  fan:        ,
+    //     /
+    uint32_t first = 0; //      
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        if (restart && indices[i] == restartIndex)
+        {
+            first = i + 1;
+            continue;
+        }
+        uint32_t n = i - first; //    
+        if (n < 2)
+            continue;
+
+        uint32_t i0, i1, i2 = indices[i];
+        if (topology == PrimitiveTopology::TriangleStrip)
+        {
+            //    ,   
+            i0 = indices[i - 2];
+            i1 = indices[i - 1];
+            if (n & 1)
+                std::swap(i0, i1);
+        }
+        else
+        {
+            i0 = indices[first];
+            i1 = indices[i - 1];
+        }
+
+        //   (   )  
+        if (i0 == i1 || i1 == i2 || i0 == i2)
+            continue;
+        m_triangles.push_back({(int)i0, (int)i1, (int)i2});
+    }
+}
+
 void Device::DrawIndexed()
 {
     //      ,   
-    uint32_t count = (uint32_t)m_DeviceContext.GetIndexBuffer().Size();
+    uint32_t count = (uint32_t)m_DeviceContext.GetIndexBufferView().IndexCount();
     DrawIndexed(count, 0);
 }
 
 void Device::Present()
 {
+    //     
+    retireDynamicBuffers(false);
+    m_uploadRing.FinishFrame();
+
     HDC hdc = GetDC(m_params.hDeviceWindow);
     if (hdc) {
         RECT clientRect;
@@ -7,13 +7,33 @@ SOFTX_BEGIN
 DeviceContext::DeviceContext() : 
 	m_VertexShader(nullptr), 
 	m_PixelShader(nullptr), 
+	m_VertexProgram(nullptr), 
+	m_PixelProgram(nullptr), 
+	m_QuadPixelProgram(nullptr), 
+	m_VertexVaryingCount(0), 
+	m_PixelVaryingCount(0), 
+	m_InputLayout(DefaultInputLayout()), 
 	m_VertexBuffer(), 
 	m_IndexBuffer(), 
+	m_InstanceBuffer(), 
 	m_ConstantBuffer(),
-	m_RenderTarget(nullptr), 
+	m_RenderTargets(), 
+	m_RenderTargetCount(0), 
+	m_DepthTarget(nullptr), 
+	m_DepthFunc(DepthFunc::Less), 
+	m_DepthWrite(true), 
+	m_Predication(nullptr), 
 	m_cullMode(CullMode::Back), 
 	m_fillMode(FillMode::Solid), 
-	m_Viewport(),
+	m_topology(PrimitiveTopology::TriangleList), 
+	m_primitiveRestart(false), 
+	m_ViewProjection(), 
+	m_DrawBounds(), 
+	m_Viewports(), 
+	m_ViewportCount(1), 
+	m_ScissorRects(), 
+	m_ScissorRectCount(0), 
+	m_ScissorEnable(false), 
 	m_EnableTiledRendering(true), 
 	m_TileSize(64)
 {
@@ -21,9 +41,64 @@ DeviceContext::DeviceContext() :
 
 DeviceContext::~DeviceContext() = default;
 
+namespace
+{
+//     :      
+QuadPixelProgram wrapPixelProgram(PixelProgram program, uint32_t varyingCount)
+{
+	return [program, varyingCount](const PixelQuadInput& in, PixelQuadOutput& out, ConstantBuffer cb) {
+		alignas(16) float x[4], y[4], z[4];
+		alignas(16) float vary[MAX_VARYINGS][4];
+		_mm_store_ps(x, in.X);
+		_mm_store_ps(y, in.Y);
+		_mm_store_ps(z, in.Z);
+		for (uint32_t k = 0; k < varyingCount; ++k)
+			_mm_store_ps(vary[k], in.Attributes[k]);
+
+		PixelInput frag;
+		frag.Samplers = in.Samplers;
+		std::memcpy(frag.Ddx.v, in.Ddx.v, varyingCount * sizeof(float));
+		std::memcpy(frag.Ddy.v, in.Ddy.v, varyingCount * sizeof(float));
+
+		__m128 color[4] = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			if (!(in.Mask & (1 << i)))
+				continue;
+			frag.Position = float4(x[i], y[i], z[i], 1.0f);
+			for (uint32_t k = 0; k < varyingCount; ++k)
+				frag.Attributes.v[k] = vary[k][i];
+			color[i] = program(frag, cb).v;
+		}
+		_MM_TRANSPOSE4_PS(color[0], color[1], color[2], color[3]);
+		out.R = color[0];
+		out.G = color[1];
+		out.B = color[2];
+		out.A = color[3];
+	};
+}
+} // namespace
+
 void DeviceContext::SetVertexShader(VertexShader shader)
 {
 	m_VertexShader = std::move(shader);
+	if (!m_VertexShader)
+	{
+		m_VertexProgram = nullptr;
+		m_VertexVaryingCount = 0;
+		return;
+	}
+
+	//     VertexProgram:  0..2  -> VertexInput,
+	//   UV  VertexOutput -> varyings VARYING_COLOR  VARYING_UV
+	VertexShader vs = m_VertexShader;
+	m_VertexProgram = [vs](const VertexAttributes& in, Varyings& out, ConstantBuffer cb) {
+		VertexOutput o = vs(VertexInput(in.Get3(0), in.Get(1), in.Get2(2)), cb);
+		out.Set(VARYING_COLOR, o.Color);
+		out.Set(VARYING_UV, o.UV);
+		return o.Position;
+	};
+	m_VertexVaryingCount = LEGACY_VARYING_COUNT;
 }
 
 VertexShader DeviceContext::GetVertexShader() const
@@ -34,6 +109,24 @@ VertexShader DeviceContext::GetVertexShader() const
 void DeviceContext::SetPixelShader(PixelShader shader)
 {
 	m_PixelShader = std::move(shader);
+	if (!m_PixelShader)
+	{
+		m_PixelProgram = nullptr;
+		m_QuadPixelProgram = nullptr;
+		m_PixelVaryingCount = 0;
+		return;
+	}
+
+	PixelShader ps = m_PixelShader;
+	m_PixelProgram = [ps](const PixelInput& in, ConstantBuffer cb) {
+		VertexOutput frag;
+		frag.Position = in.Position;
+		frag.Color = in.Attributes.Get4(VARYING_COLOR);
+		frag.UV = in.Attributes.Get2(VARYING_UV);
+		return ps(frag, cb);
+	};
+	m_PixelVaryingCount = LEGACY_VARYING_COUNT;
+	m_QuadPixelProgram = wrapPixelProgram(m_PixelProgram, m_PixelVaryingCount);
 }
 
 PixelShader DeviceContext::GetPixelShader() const
@@ -41,26 +134,114 @@ PixelShader DeviceContext::GetPixelShader() const
 	return m_PixelShader;
 }
 
+void DeviceContext::SetVertexProgram(VertexProgram program, uint32_t varyingCount)
+{
+	m_VertexShader = nullptr;
+	m_VertexProgram = std::move(program);
+	m_VertexVaryingCount = varyingCount;
+}
+
+VertexProgram DeviceContext::GetVertexProgram() const
+{
+	return m_VertexProgram;
+}
+
+uint32_t DeviceContext::GetVertexVaryingCount() const
+{
+	return m_VertexVaryingCount;
+}
+
+void DeviceContext::SetPixelProgram(PixelProgram program, uint32_t varyingCount)
+{
+	m_PixelShader = nullptr;
+	m_PixelProgram = std::move(program);
+	m_PixelVaryingCount = varyingCount;
+	m_QuadPixelProgram = m_PixelProgram ? wrapPixelProgram(m_PixelProgram, varyingCount) : nullptr;
+}
+
+PixelProgram DeviceContext::GetPixelProgram() const
+{
+	return m_PixelProgram;
+}
+
+uint32_t DeviceContext::GetPixelVaryingCount() const
+{
+	return m_PixelVaryingCount;
+}
+
+void DeviceContext::SetQuadPixelProgram(QuadPixelProgram program, uint32_t varyingCount)
+{
+	m_PixelShader = nullptr;
+	m_PixelProgram = nullptr;
+	m_QuadPixelProgram = std::move(program);
+	m_PixelVaryingCount = varyingCount;
+}
+
+QuadPixelProgram DeviceContext::GetQuadPixelProgram() const
+{
+	return m_QuadPixelProgram;
+}
+
+void DeviceContext::SetInputLayout(const InputLayout& layout)
+{
+	m_InputLayout = layout;
+}
+
+InputLayout DeviceContext::GetInputLayout() const
+{
+	return m_InputLayout;
+}
+
 void DeviceContext::SetVertexBuffer(const VertexBuffer& buffer)
 {
-	m_VertexBuffer = buffer;
+	m_VertexBuffer = buffer.View();
+}
+
+void DeviceContext::SetVertexBuffer(const VertexBufferView& view)
+{
+	m_VertexBuffer = view;
 }
 
 VertexBuffer DeviceContext::GetVertexBuffer() const
+{
+	return VertexBuffer(m_VertexBuffer.Buffer, m_VertexBuffer.Stride);
+}
+
+const VertexBufferView& DeviceContext::GetVertexBufferView() const
 {
 	return m_VertexBuffer;
 }
 
 void DeviceContext::SetIndexBuffer(const IndexBuffer& buffer)
 {
-	m_IndexBuffer = buffer;
+	m_IndexBuffer = buffer.View();
+}
+
+void DeviceContext::SetIndexBuffer(const IndexBufferView& view)
+{
+	m_IndexBuffer = view;
 }
 
 IndexBuffer DeviceContext::GetIndexBuffer() const
+{
+	return IndexBuffer(m_IndexBuffer.Buffer);
+}
+
+const IndexBufferView& DeviceContext::GetIndexBufferView() const
 {
 	return m_IndexBuffer;
 }
 
+void DeviceContext::SetInstanceBuffer(const VertexBufferView& view)
+{
+	m_InstanceBuffer = view;
+}
+
+const VertexBufferView& DeviceContext::GetInstanceBufferView() const
+{
+	return m_InstanceBuffer;
+}
+
 void DeviceContext::SetConstantBuffer(const ConstantBuffer& buffer)
 {
 	m_ConstantBuffer = buffer;
@@ -71,14 +252,100 @@ ConstantBuffer DeviceContext::GetConstantBuffer() const
 	return m_ConstantBuffer;
 }
 
+void DeviceContext::SetSampler(uint32_t slot, const SamplerState& sampler)
+{
+	assert(slot < MAX_SAMPLERS);
+	if (slot < MAX_SAMPLERS)
+		m_Samplers[slot] = sampler;
+}
+
+const SamplerState& DeviceContext::GetSampler(uint32_t slot) const
+{
+	assert(slot < MAX_SAMPLERS);
+	return m_Samplers[slot];
+}
+
+const SamplerState* DeviceContext::GetSamplers() const
+{
+	return m_Samplers;
+}
+
+void DeviceContext::SetBlendState(const BlendState& state)
+{
+	m_BlendState = state;
+}
+
+const BlendState& DeviceContext::GetBlendState() const
+{
+	return m_BlendState;
+}
+
+void DeviceContext::SetDepthTarget(DepthBuffer* target)
+{
+	m_DepthTarget = target;
+}
+
+DepthBuffer* DeviceContext::GetDepthTarget() const
+{
+	return m_DepthTarget;
+}
+
+void DeviceContext::SetDepthFunc(DepthFunc func)
+{
+	m_DepthFunc = func;
+}
+
+DepthFunc DeviceContext::GetDepthFunc() const
+{
+	return m_DepthFunc;
+}
+
+void DeviceContext::SetDepthWrite(bool enable)
+{
+	m_DepthWrite = enable;
+}
+
+bool DeviceContext::GetDepthWrite() const
+{
+	return m_DepthWrite;
+}
+
+void DeviceContext::SetPredication(const OcclusionQuery* query)
+{
+	m_Predication = query;
+}
+
+const OcclusionQuery* DeviceContext::GetPredication() const
+{
+	return m_Predication;
+}
+
 void DeviceContext::SetRenderTarget(IRenderTarget* target)
 {
-	m_RenderTarget = target;
+	SetRenderTargets(target ? 1 : 0, &target);
 }
 
-IRenderTarget* DeviceContext::GetRenderTarget() const
+IRenderTarget* DeviceContext::GetRenderTarget(uint32_t slot) const
 {
-	return m_RenderTarget;
+	return slot < m_RenderTargetCount ? m_RenderTargets[slot] : nullptr;
+}
+
+void DeviceContext::SetRenderTargets(uint32_t count, IRenderTarget* const* targets)
+{
+	assert(count <= MAX_RENDER_TARGETS);
+	if (count > MAX_RENDER_TARGETS)
+	{
+		printf("Too many render targets %u ", count);
+		count = MAX_RENDER_TARGETS;
+	}
+	for (uint32_t i = 0; i < MAX_RENDER_TARGETS; ++i)
+		m_RenderTargets[i] = i < count ? targets[i] : nullptr;
+	m_RenderTargetCount = count;
+}
+
+uint32_t DeviceContext::GetRenderTargetCount() const
+{
+	return m_RenderTargetCount;
 }
 
 void DeviceContext::SetCullMode(CullMode mode)
@@ -101,14 +368,110 @@ FillMode DeviceContext::GetFillMode() const
 	return m_fillMode;
 }
 
+void DeviceContext::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	m_topology = topology;
+}
+
+PrimitiveTopology DeviceContext::GetPrimitiveTopology() const
+{
+	return m_topology;
+}
+
+void DeviceContext::SetPrimitiveRestart(bool enable)
+{
+	m_primitiveRestart = enable;
+}
+
+bool DeviceContext::GetPrimitiveRestart() const
+{
+	return m_primitiveRestart;
+}
+
+void DeviceContext::SetViewProjection(const float4x4& viewProjection)
+{
+	m_ViewProjection = viewProjection;
+}
+
+const float4x4& DeviceContext::GetViewProjection() const
+{
+	return m_ViewProjection;
+}
+
+void DeviceContext::SetDrawBounds(const DrawBounds& bounds)
+{
+	m_DrawBounds = bounds;
+}
+
+const DrawBounds& DeviceContext::GetDrawBounds() const
+{
+	return m_DrawBounds;
+}
+
 void DeviceContext::SetViewport(const Viewport& vp)
 {
-	m_Viewport = vp;
+	SetViewports(1, &vp);
 }
 
-Viewport DeviceContext::GetViewport() const
+Viewport DeviceContext::GetViewport(uint32_t slot) const
 {
-	return m_Viewport;
+	return slot < m_ViewportCount ? m_Viewports[slot] : Viewport();
+}
+
+void DeviceContext::SetViewports(uint32_t count, const Viewport* viewports)
+{
+	assert(count <= MAX_VIEWPORTS);
+	if (count > MAX_VIEWPORTS)
+	{
+		printf("Too many viewports %u ", count);
+		count = MAX_VIEWPORTS;
+	}
+	for (uint32_t i = 0; i < MAX_VIEWPORTS; ++i)
+		m_Viewports[i] = i < count ? viewports[i] : Viewport();
+	m_ViewportCount = count;
+}
+
+uint32_t DeviceContext::GetViewportCount() const
+{
+	return m_ViewportCount;
+}
+
+void DeviceContext::SetScissorEnable(bool enable)
+{
+	m_ScissorEnable = enable;
+}
+
+bool DeviceContext::GetScissorEnable() const
+{
+	return m_ScissorEnable;
+}
+
+void DeviceContext::SetScissorRect(const ScissorRect& rect)
+{
+	SetScissorRects(1, &rect);
+}
+
+void DeviceContext::SetScissorRects(uint32_t count, const ScissorRect* rects)
+{
+	assert(count <= MAX_VIEWPORTS);
+	if (count > MAX_VIEWPORTS)
+	{
+		printf("Too many scissor rects %u ", count);
+		count = MAX_VIEWPORTS;
+	}
+	for (uint32_t i = 0; i < MAX_VIEWPORTS; ++i)
+		m_ScissorRects[i] = i < count ? rects[i] : ScissorRect();
+	m_ScissorRectCount = count;
+}
+
+const ScissorRect& DeviceContext::GetScissorRect(uint32_t slot) const
+{
+	return m_ScissorRects[slot < MAX_VIEWPORTS ? slot : 0];
+}
+
+uint32_t DeviceContext::GetScissorRectCount() const
+{
+	return m_ScissorRectCount;
 }
 
 void DeviceContext::SetTileRenderingState(bool enable)
@@ -131,24 +494,39 @@ uint32_t DeviceContext::GetTileSize() const
 	return m_TileSize;
 }
 
-bool DeviceContext::Validate(std::string* errorMsg) const
+bool DeviceContext::Validate(std::string* errorMsg, bool indexed) const
 {
 	bool bCheckResult = true;
 
 	//   
-	if (!m_VertexShader)
+	if (!m_VertexProgram)
 	{
 		if (errorMsg)
 			*errorMsg = "Vertex shader not set ";
 		bCheckResult = false;
 	}
-	//   
-	if (!m_PixelShader)
+	//    ( ,    )
+	bool depthOnly = m_RenderTargetCount == 0 && !m_QuadPixelProgram;
+	if (!m_QuadPixelProgram && !depthOnly)
 	{
 		if (errorMsg)
 			*errorMsg += "Pixel shader not set ";
 		bCheckResult = false;
 	}
+	//   varyings
+	if (m_VertexVaryingCount > MAX_VARYINGS || m_PixelVaryingCount > MAX_VARYINGS)
+	{
+		if (errorMsg)
+			*errorMsg += "Too many varyings ";
+		bCheckResult = false;
+	}
+	//   
+	if (m_InputLayout.IsEmpty())
+	{
+		if (errorMsg)
+			*errorMsg += "Input layout is empty ";
+		bCheckResult = false;
+	}
 	//   
 	if (m_VertexBuffer.IsEmpty())
 	{
@@ -157,24 +535,73 @@ bool DeviceContext::Validate(std::string* errorMsg) const
 		bCheckResult = false;
 	}
 	//   
-	if (m_IndexBuffer.IsEmpty())
+	if (indexed && m_IndexBuffer.IsEmpty())
 	{
 		if (errorMsg)
 			*errorMsg += "Index buffer is empty ";
 		bCheckResult = false;
 	}
-	//  
-	if (m_RenderTarget == nullptr)
+	//    (,     )
+	if (m_InputLayout.HasPerInstanceElements() && m_InstanceBuffer.IsEmpty())
+	{
+		if (errorMsg)
+			*errorMsg += "Instance buffer is empty ";
+		bCheckResult = false;
+	}
+	//  :  ,       ,   -  
+	if (!depthOnly && (m_RenderTargetCount == 0 || m_RenderTargets[0] == nullptr))
 	{
 		if (errorMsg)
 			*errorMsg += "Render target not set ";
 		bCheckResult = false;
 	}
+	else if (m_RenderTargetCount > 0)
+	{
+		for (uint32_t i = 1; i < m_RenderTargetCount; ++i)
+		{
+			if (m_RenderTargets[i] == nullptr || m_RenderTargets[i]->size() != m_RenderTargets[0]->size())
+			{
+				if (errorMsg)
+					*errorMsg += "Render targets differ in size ";
+				bCheckResult = false;
+				break;
+			}
+			if (m_RenderTargets[i]->sample_count() != m_RenderTargets[0]->sample_count())
+			{
+				if (errorMsg)
+					*errorMsg += "Render targets differ in sample count ";
+				bCheckResult = false;
+				break;
+			}
+		}
+		if (m_DepthTarget && m_DepthTarget->size() != m_RenderTargets[0]->size())
+		{
+			if (errorMsg)
+				*errorMsg += "Depth target differs in size ";
+			bCheckResult = false;
+		}
+	}
 	//  viewport (   )
-	if (m_Viewport.size.x <= 0.0f || m_Viewport.size.y <= 0.0f)
+	if (m_ViewportCount == 0)
+	{
+		if (errorMsg)
+			*errorMsg += "Viewport not set ";
+		bCheckResult = false;
+	}
+	for (uint32_t i = 0; i < m_ViewportCount; ++i)
+	{
+		if (m_Viewports[i].size.x <= 0.0f || m_Viewports[i].size.y <= 0.0f)
+		{
+			if (errorMsg)
+				*errorMsg += "Viewport has non-positive size ";
+			bCheckResult = false;
+			break;
+		}
+	}
+	if (m_ScissorEnable && m_ScissorRectCount < m_ViewportCount)
 	{
 		if (errorMsg)
-			*errorMsg += "Viewport has non-positive size ";
+			*errorMsg += "Scissor rect not set for every viewport ";
 		bCheckResult = false;
 	}
 	//    (  )
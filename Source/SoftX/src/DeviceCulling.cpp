@@ -0,0 +1,313 @@
+#include "pch.h"
+#include <SoftX/SoftX.h>
+#include <cfloat>
+
+SOFTX_BEGIN
+
+// ==========      ==========
+
+namespace
+{
+//      SoA:     ,
+//     (0, 0, 0, 1),    
+struct FrustumPlanes
+{
+    __m128 X[2], Y[2], Z[2], W[2];
+};
+
+//        clip = m * p ( - )
+FrustumPlanes extractPlanes(const float4x4& m)
+{
+    __m128 planes[8] = {
+        _mm_add_ps(m.r3.v, m.r0.v), // :   x >= -w
+        _mm_sub_ps(m.r3.v, m.r0.v), // :  x <= w
+        _mm_add_ps(m.r3.v, m.r1.v), // :  y >= -w
+        _mm_sub_ps(m.r3.v, m.r1.v), // : y <= w
+        m.r2.v,                     // : z >= 0
+        _mm_sub_ps(m.r3.v, m.r2.v), // : z <= w
+        _mm_setr_ps(0, 0, 0, 1),
+        _mm_setr_ps(0, 0, 0, 1),
+    };
+
+    FrustumPlanes f;
+    for (int g = 0; g < 2; ++g)
+    {
+        __m128 p0 = planes[g * 4 + 0], p1 = planes[g * 4 + 1], p2 = planes[g * 4 + 2], p3 = planes[g * 4 + 3];
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        f.X[g] = p0;
+        f.Y[g] = p1;
+        f.Z[g] = p2;
+        f.W[g] = p3;
+    }
+    return f;
+}
+
+// Box:     ,     .
+//         -  box 
+bool boxOutside(const FrustumPlanes& f, const BoundingBox& box)
+{
+    __m128 zero = _mm_setzero_ps();
+    for (int g = 0; g < 2; ++g)
+    {
+        __m128 px = _mm_blendv_ps(_mm_set1_ps(box.Min.x), _mm_set1_ps(box.Max.x), _mm_cmpgt_ps(f.X[g], zero));
+        __m128 py = _mm_blendv_ps(_mm_set1_ps(box.Min.y), _mm_set1_ps(box.Max.y), _mm_cmpgt_ps(f.Y[g], zero));
+        __m128 pz = _mm_blendv_ps(_mm_set1_ps(box.Min.z), _mm_set1_ps(box.Max.z), _mm_cmpgt_ps(f.Z[g], zero));
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f.X[g], px), _mm_mul_ps(f.Y[g], py)),
+                                 _mm_add_ps(_mm_mul_ps(f.Z[g], pz), f.W[g]));
+        if (_mm_movemask_ps(_mm_cmplt_ps(dist, zero)))
+            return true;
+    }
+    return false;
+}
+
+// Sphere:     -radius (  ,  
+//    )
+bool sphereOutside(const FrustumPlanes& f, const BoundingSphere& sphere)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 cx = _mm_set1_ps(sphere.Center.x);
+    __m128 cy = _mm_set1_ps(sphere.Center.y);
+    __m128 cz = _mm_set1_ps(sphere.Center.z);
+    __m128 r = _mm_set1_ps(sphere.Radius);
+    for (int g = 0; g < 2; ++g)
+    {
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f.X[g], f.X[g]), _mm_mul_ps(f.Y[g], f.Y[g])),
+                                 _mm_mul_ps(f.Z[g], f.Z[g]));
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f.X[g], cx), _mm_mul_ps(f.Y[g], cy)),
+                                 _mm_add_ps(_mm_mul_ps(f.Z[g], cz), f.W[g]));
+        dist = _mm_add_ps(dist, _mm_mul_ps(r, _mm_sqrt_ps(len2)));
+        if (_mm_movemask_ps(_mm_cmplt_ps(dist, zero)))
+            return true;
+    }
+    return false;
+}
+} // namespace
+
+bool Device::isCulled(const DrawBounds& bounds) const
+{
+    if (bounds.Type == BoundsType::None)
+        return false;
+
+    FrustumPlanes f = extractPlanes(m_DeviceContext.GetViewProjection() * bounds.World);
+    if (bounds.Type == BoundsType::Box)
+        return boxOutside(f, bounds.Box);
+    return sphereOutside(f, bounds.Sphere);
+}
+
+bool Device::isPredicatedOff() const
+{
+    const OcclusionQuery* predicate = m_DeviceContext.GetPredication();
+    return predicate && predicate->SamplesPassed == 0;
+}
+
+// ==========   (DrawMeshlets) ==========
+
+//      HiZ
+static constexpr int HIZ_BLOCK_SHIFT = 3;
+
+namespace
+{
+//  HiZ  ,   :   Less,   Greater
+template <bool Greater> float hiZReduce(float a, float b)
+{
+    return Greater ? std::min(a, b) : std::max(a, b);
+}
+
+template <bool Greater> __m128 hiZReduce(__m128 a, __m128 b)
+{
+    return Greater ? _mm_min_ps(a, b) : _mm_max_ps(a, b);
+}
+
+//  :   8x8   samples   (  ),
+//    8    SSE
+template <bool Greater>
+void reduceBlocks(const float* depth, int width, int height, int samples, float* dst, int dstWidth)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        const float* row = depth + (size_t)y * width * samples;
+        float* out = dst + (size_t)(y >> HIZ_BLOCK_SHIFT) * dstWidth;
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const float* block = row + (size_t)x * samples;
+            __m128 m = _mm_loadu_ps(block);
+            for (int i = 4; i < 8 * samples; i += 4)
+                m = hiZReduce<Greater>(m, _mm_loadu_ps(block + i));
+            m = hiZReduce<Greater>(m, _mm_movehl_ps(m, m));
+            m = hiZReduce<Greater>(m, _mm_shuffle_ps(m, m, 1));
+            float& d = out[x >> HIZ_BLOCK_SHIFT];
+            d = hiZReduce<Greater>(d, _mm_cvtss_f32(m));
+        }
+        for (; x < width; ++x)
+        {
+            float& d = out[x >> HIZ_BLOCK_SHIFT];
+            for (int i = 0; i < samples; ++i)
+                d = hiZReduce<Greater>(d, row[(size_t)x * samples + i]);
+        }
+    }
+}
+
+//  :  2x2 (    )
+template <bool Greater>
+void reduceLevel(const float* src, int srcWidth, int srcHeight, float* dst, int dstWidth, int dstHeight)
+{
+    for (int y = 0; y < dstHeight; ++y)
+    {
+        const float* row0 = src + (size_t)(y * 2) * srcWidth;
+        const float* row1 = src + (size_t)std::min(y * 2 + 1, srcHeight - 1) * srcWidth;
+        for (int x = 0; x < dstWidth; ++x)
+        {
+            int x0 = x * 2, x1 = std::min(x * 2 + 1, srcWidth - 1);
+            dst[(size_t)y * dstWidth + x] = hiZReduce<Greater>(hiZReduce<Greater>(row0[x0], row0[x1]),
+                                                               hiZReduce<Greater>(row1[x0], row1[x1]));
+        }
+    }
+}
+} // namespace
+
+void Device::buildHiZ(const float* depth, int2 size, int samples, bool greater)
+{
+    int width = size.x;
+    int height = size.y;
+
+    m_hiZ.resize(1);
+    HiZLevel& base = m_hiZ[0];
+    base.Width = (width + (1 << HIZ_BLOCK_SHIFT) - 1) >> HIZ_BLOCK_SHIFT;
+    base.Height = (height + (1 << HIZ_BLOCK_SHIFT) - 1) >> HIZ_BLOCK_SHIFT;
+    base.Depth.assign((size_t)base.Width * base.Height, greater ? FLT_MAX : 0.0f);
+    if (greater)
+        reduceBlocks<true>(depth, width, height, samples, base.Depth.data(), base.Width);
+    else
+        reduceBlocks<false>(depth, width, height, samples, base.Depth.data(), base.Width);
+
+    //     
+    while (m_hiZ.back().Width > 1 || m_hiZ.back().Height > 1)
+    {
+        const HiZLevel& src = m_hiZ.back();
+        HiZLevel next;
+        next.Width = (src.Width + 1) / 2;
+        next.Height = (src.Height + 1) / 2;
+        next.Depth.resize((size_t)next.Width * next.Height);
+        if (greater)
+            reduceLevel<true>(src.Depth.data(), src.Width, src.Height, next.Depth.data(), next.Width, next.Height);
+        else
+            reduceLevel<false>(src.Depth.data(), src.Width, src.Height, next.Depth.data(), next.Width, next.Height);
+        m_hiZ.push_back(std::move(next));
+    }
+}
+
+void Device::cullMeshlets(const MeshletMesh& mesh, const float4x4& world, uint32_t cullFlags)
+{
+    const float4x4 m = m_DeviceContext.GetViewProjection() * world;
+    FrustumPlanes f = extractPlanes(m);
+    bool testFrustum = (cullFlags & MESHLET_CULL_FRUSTUM) != 0;
+
+    //     -   (0, 0, 1, 0):   x = y = w = 0.
+    //      (w = 0),    
+    bool testCone = (cullFlags & MESHLET_CULL_BACKFACE) && m_DeviceContext.GetCullMode() == CullMode::Back;
+    float3 eye(0, 0, 0);
+    if (testCone)
+    {
+        float4 e = inverse(m) * float4(0, 0, 1, 0);
+        if (std::abs(e.w) < 1e-8f)
+            testCone = false;
+        else
+            eye = float3(e.x / e.w, e.y / e.w, e.z / e.w);
+    }
+
+    // HiZ      :  Less/LessEqual  
+    // ,  Greater/GreaterEqual - .  Always/Never/Equal/NotEqual  
+    bool greater = m_depthFunc == DepthFunc::Greater || m_depthFunc == DepthFunc::GreaterEqual;
+    bool less = m_depthFunc == DepthFunc::Less || m_depthFunc == DepthFunc::LessEqual;
+    bool testOcclusion = (cullFlags & MESHLET_CULL_OCCLUSION) && (less || greater);
+    //  MSAA       m_sampleDepth, m_depthTarget 
+    int2 depthSize = m_sampleCount > 1 ? m_targetSize : m_depthTarget->size();
+    if (testOcclusion)
+        buildHiZ(m_sampleCount > 1 ? m_sampleDepth.data() : m_depthTarget->data(), depthSize, (int)m_sampleCount,
+                 greater);
+
+    // HiZ:         AABB  
+    //   ,       2x2 
+    auto occluded = [&](const BoundingSphere& s) {
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX, maxZ = -FLT_MAX;
+        for (int c = 0; c < 8; ++c)
+        {
+            float4 corner(s.Center.x + ((c & 1) ? s.Radius : -s.Radius), s.Center.y + ((c & 2) ? s.Radius : -s.Radius),
+                          s.Center.z + ((c & 4) ? s.Radius : -s.Radius), 1.0f);
+            float4 clip = m * corner;
+            //     -  ,  
+            if (clip.w <= 1e-6f || clip.z < 0.0f)
+                return false;
+            float4 p = ClipToScreen(clip);
+            minX = std::min(minX, p.x);
+            maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+            minZ = std::min(minZ, p.z);
+            maxZ = std::max(maxZ, p.z);
+        }
+
+        int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(depthSize.x - 1, (int)maxX);
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(depthSize.y - 1, (int)maxY);
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        int level = 0;
+        int shift = HIZ_BLOCK_SHIFT;
+        while (level + 1 < (int)m_hiZ.size() && ((x1 >> shift) - (x0 >> shift) > 1 || (y1 >> shift) - (y0 >> shift) > 1))
+        {
+            ++level;
+            ++shift;
+        }
+
+        const HiZLevel& hiz = m_hiZ[level];
+        float farDepth = greater ? FLT_MAX : 0.0f;
+        for (int y = y0 >> shift; y <= (y1 >> shift); ++y)
+            for (int x = x0 >> shift; x <= (x1 >> shift); ++x)
+            {
+                float d = hiz.Depth[(size_t)y * hiz.Width + x];
+                farDepth = greater ? std::min(farDepth, d) : std::max(farDepth, d);
+            }
+        return greater ? maxZ < farDepth : minZ > farDepth;
+    };
+
+    auto cullRange = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const Meshlet& meshlet = mesh.Meshlets[i];
+            bool visible = true;
+            if (testFrustum && sphereOutside(f, meshlet.Bounds))
+                visible = false;
+            else if (testCone && meshlet.ConeCutoff < 1.0f)
+            {
+                //       (    )
+                float3 d = meshlet.Bounds.Center - eye;
+                if (dot(d, meshlet.ConeAxis) >= meshlet.ConeCutoff * sqrtf(dot(d, d)) + meshlet.Bounds.Radius)
+                    visible = false;
+            }
+            if (visible && testOcclusion && occluded(meshlet.Bounds))
+                visible = false;
+            m_meshletVisible[i] = visible;
+        }
+    };
+
+    uint32_t count = (uint32_t)mesh.Meshlets.size();
+    m_meshletVisible.resize(count);
+    uint32_t numThreads = (uint32_t)m_threadPool->threadCount();
+    if (count < PARALLEL_MESHLET_THRESHOLD || numThreads < 2)
+    {
+        cullRange(0, count);
+        return;
+    }
+
+    uint32_t chunk = (count + numThreads * 4 - 1) / (numThreads * 4);
+    for (uint32_t begin = 0; begin < count; begin += chunk)
+    {
+        uint32_t end = std::min(begin + chunk, count);
+        m_threadPool->enqueue([&cullRange, begin, end]() { cullRange(begin, end); });
+    }
+    m_threadPool->wait();
+}
+
+SOFTX_END
@@ -0,0 +1,245 @@
+#include "pch.h"
+#include <SoftX/SoftX.h>
+#include <atomic>
+
+SOFTX_BEGIN
+
+namespace
+{
+//   2x2  SoA: src -  , dest -  ,  -  dest.
+//         ,   -  
+
+__m128 blendFactor(BlendFactor factor, const __m128 src[4], const __m128 dest[4], __m128 constant, int channel)
+{
+    __m128 one = _mm_set1_ps(1.0f);
+    switch (factor)
+    {
+    case BlendFactor::Zero:
+        return _mm_setzero_ps();
+    case BlendFactor::One:
+        return one;
+    case BlendFactor::SrcColor:
+        return src[channel];
+    case BlendFactor::InvSrcColor:
+        return _mm_sub_ps(one, src[channel]);
+    case BlendFactor::SrcAlpha:
+        return src[3];
+    case BlendFactor::InvSrcAlpha:
+        return _mm_sub_ps(one, src[3]);
+    case BlendFactor::DestAlpha:
+        return dest[3];
+    case BlendFactor::InvDestAlpha:
+        return _mm_sub_ps(one, dest[3]);
+    case BlendFactor::DestColor:
+        return dest[channel];
+    case BlendFactor::InvDestColor:
+        return _mm_sub_ps(one, dest[channel]);
+    case BlendFactor::SrcAlphaSat:
+        return channel == 3 ? one : _mm_min_ps(src[3], _mm_sub_ps(one, dest[3]));
+    case BlendFactor::Constant:
+        return constant;
+    case BlendFactor::InvConstant:
+        return _mm_sub_ps(one, constant);
+    }
+    return one;
+}
+
+__m128 blendOp(BlendOp op, __m128 src, __m128 dest, __m128 srcFactor, __m128 destFactor)
+{
+    switch (op)
+    {
+    case BlendOp::Add:
+        return _mm_add_ps(_mm_mul_ps(src, srcFactor), _mm_mul_ps(dest, destFactor));
+    case BlendOp::Subtract:
+        return _mm_sub_ps(_mm_mul_ps(src, srcFactor), _mm_mul_ps(dest, destFactor));
+    case BlendOp::RevSubtract:
+        return _mm_sub_ps(_mm_mul_ps(dest, destFactor), _mm_mul_ps(src, srcFactor));
+    case BlendOp::Min:
+        return _mm_min_ps(src, dest);
+    case BlendOp::Max:
+        return _mm_max_ps(src, dest);
+    }
+    return src;
+}
+
+void blendGeneric(const BlendState& state, const __m128 src[4], __m128 dest[4])
+{
+    if (!state.BlendEnable)
+    {
+        for (int ch = 0; ch < 4; ++ch)
+            dest[ch] = src[ch];
+        return;
+    }
+
+    const float constant[4] = {state.ConstantColor.x, state.ConstantColor.y, state.ConstantColor.z,
+                               state.ConstantColor.w};
+    __m128 result[4];
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        bool alpha = ch == 3;
+        __m128 c = _mm_set1_ps(constant[ch]);
+        __m128 srcFactor = blendFactor(alpha ? state.SrcBlendAlpha : state.SrcBlend, src, dest, c, ch);
+        __m128 destFactor = blendFactor(alpha ? state.DestBlendAlpha : state.DestBlend, src, dest, c, ch);
+        result[ch] = blendOp(alpha ? state.OpAlpha : state.Op, src[ch], dest[ch], srcFactor, destFactor);
+    }
+    for (int ch = 0; ch < 4; ++ch)
+        dest[ch] = result[ch];
+}
+
+// src + dest * (1 - As)   
+void blendPremultiplied(const BlendState&, const __m128 src[4], __m128 dest[4])
+{
+    __m128 invAlpha = _mm_sub_ps(_mm_set1_ps(1.0f), src[3]);
+    for (int ch = 0; ch < 4; ++ch)
+        dest[ch] = _mm_add_ps(src[ch], _mm_mul_ps(dest[ch], invAlpha));
+}
+
+// : dest + (src - dest) * As; : As + Ad * (1 - As)
+void blendAlpha(const BlendState&, const __m128 src[4], __m128 dest[4])
+{
+    __m128 alpha = src[3];
+    for (int ch = 0; ch < 3; ++ch)
+        dest[ch] = _mm_add_ps(dest[ch], _mm_mul_ps(_mm_sub_ps(src[ch], dest[ch]), alpha));
+    dest[3] = _mm_add_ps(alpha, _mm_mul_ps(dest[3], _mm_sub_ps(_mm_set1_ps(1.0f), alpha)));
+}
+
+void blendAdditive(const BlendState&, const __m128 src[4], __m128 dest[4])
+{
+    for (int ch = 0; ch < 4; ++ch)
+        dest[ch] = _mm_add_ps(src[ch], dest[ch]);
+}
+
+//    (ConstantColor     )
+bool sameEquation(const BlendState& a, const BlendState& b)
+{
+    return a.SrcBlend == b.SrcBlend && a.DestBlend == b.DestBlend && a.Op == b.Op &&
+           a.SrcBlendAlpha == b.SrcBlendAlpha && a.DestBlendAlpha == b.DestBlendAlpha && a.OpAlpha == b.OpAlpha;
+}
+} // namespace
+
+void Device::setupOutputMerger()
+{
+    m_renderTargetCount = m_DeviceContext.GetRenderTargetCount();
+    for (uint32_t i = 0; i < m_renderTargetCount; ++i)
+        m_renderTargets[i] = m_DeviceContext.GetRenderTarget(i);
+
+    //          
+    m_sampleCount = m_renderTargetCount ? m_renderTargets[0]->sample_count() : 1;
+    if (m_sampleCount > 1)
+    {
+        size_t samples = (size_t)m_renderTargets[0]->width() * m_renderTargets[0]->height() * m_sampleCount;
+        if (m_sampleDepth.size() != samples)
+            m_sampleDepth.assign(samples, m_depthClearValue);
+    }
+
+    m_blendState = m_DeviceContext.GetBlendState();
+    //          
+    m_blendFunction = nullptr;
+    if (!m_blendState.BlendEnable && m_blendState.WriteMask == COLOR_WRITE_ALL)
+        return;
+
+    m_blendFunction = &blendGeneric;
+    if (!m_blendState.BlendEnable)
+        return;
+    if (sameEquation(m_blendState, BlendState::Premultiplied()))
+        m_blendFunction = &blendPremultiplied;
+    else if (sameEquation(m_blendState, BlendState::AlphaBlend()))
+        m_blendFunction = &blendAlpha;
+    else if (sameEquation(m_blendState, BlendState::Additive()))
+        m_blendFunction = &blendAdditive;
+}
+
+void Device::writeQuad(const PixelQuadOutput& color, int mask, int x, int y)
+{
+    uint8_t writeMask = m_blendState.WriteMask;
+    if (m_blendFunction && writeMask == 0)
+        return;
+
+    //      (  D3D  IndependentBlendEnable)
+    for (uint32_t target = 0; target < m_renderTargetCount; ++target)
+    {
+        IRenderTarget* rt = m_renderTargets[target];
+        const __m128* output = color.Target(target);
+        __m128 src[4] = {output[0], output[1], output[2], output[3]};
+        if (m_blendFunction)
+        {
+            //      SoA,    
+            __m128 dest[4];
+            rt->read_quad(x, y, dest);
+            __m128 blended[4] = {dest[0], dest[1], dest[2], dest[3]};
+            m_blendFunction(m_blendState, src, blended);
+            for (int ch = 0; ch < 4; ++ch)
+                src[ch] = (writeMask & (1 << ch)) ? blended[ch] : dest[ch];
+        }
+        rt->write_quad(x, y, src, mask);
+    }
+}
+
+void Device::writeQuadSamples(const PixelQuadOutput& color, int coverage, int x, int y)
+{
+    uint8_t writeMask = m_blendState.WriteMask;
+    if (m_blendFunction && writeMask == 0)
+        return;
+
+    for (uint32_t target = 0; target < m_renderTargetCount; ++target)
+    {
+        IRenderTarget* rt = m_renderTargets[target];
+        const __m128* output = color.Target(target);
+        if (!m_blendFunction)
+        {
+            rt->write_quad_samples(x, y, output, coverage);
+            continue;
+        }
+
+        //   :      
+        for (uint32_t sample = 0; sample < m_sampleCount; ++sample)
+        {
+            int mask = 0;
+            for (int i = 0; i < 4; ++i)
+                if (coverage & (1 << (i * 4 + sample)))
+                    mask |= 1 << i;
+            if (mask == 0)
+                continue;
+
+            __m128 dest[4];
+            rt->read_quad_sample(x, y, sample, dest);
+            __m128 blended[4] = {dest[0], dest[1], dest[2], dest[3]};
+            m_blendFunction(m_blendState, output, blended);
+            __m128 src[4];
+            for (int ch = 0; ch < 4; ++ch)
+                src[ch] = (writeMask & (1 << ch)) ? blended[ch] : dest[ch];
+            rt->write_quad_sample(x, y, sample, src, mask);
+        }
+    }
+}
+
+void Device::ResolveMultisample(const MultisampleFramebuffer& source, IRenderTarget& dest)
+{
+    int tileSize = (int)m_DeviceContext.GetTileSize();
+    if (tileSize <= 0)
+        tileSize = 64;
+    int tilesX = (source.width() + tileSize - 1) / tileSize;
+    int tilesY = (source.height() + tileSize - 1) / tileSize;
+    int numTiles = tilesX * tilesY;
+    std::atomic<int> tileIndex(0);
+
+    //    -     
+    auto worker = [&source, &dest, &tileIndex, numTiles, tilesX, tileSize]() {
+        while (true)
+        {
+            int idx = tileIndex.fetch_add(1);
+            if (idx >= numTiles) break;
+            int2 min((idx % tilesX) * tileSize, (idx / tilesX) * tileSize);
+            source.resolve(dest, min, int2(min.x + tileSize - 1, min.y + tileSize - 1));
+        }
+    };
+
+    int numThreads = (int)m_threadPool->threadCount();
+    for (int i = 0; i < numThreads; ++i)
+    {
+        m_threadPool->enqueue(worker);
+    }
+    m_threadPool->wait();
+}
+
+SOFTX_END
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include <SoftX/SoftX.h>
+#include <climits>
 
 SOFTX_BEGIN
 
@@ -10,14 +11,48 @@ void Device::DrawPoint(int x, int y, float z, const float4& color)
     if (x < 0 || x >= rt->width() || y < 0 || y >= rt->height())
         return;
     int idx = y * rt->width() + x;
-    if (z < m_depthBuffer.at(idx))
+    DepthFunc func = m_DeviceContext.GetDepthFunc();
+    bool depthWrite = m_DeviceContext.GetDepthWrite();
+    if (rt->sample_count() > 1)
     {
-        m_depthBuffer.at(idx) = z;
+        //  MSAA    :       
+        size_t samples = (size_t)rt->width() * rt->height() * MSAA_SAMPLE_COUNT;
+        if (m_sampleDepth.size() != samples)
+            m_sampleDepth.assign(samples, m_depthClearValue);
+        float* depth = m_sampleDepth.data() + (size_t)idx * MSAA_SAMPLE_COUNT;
+        int coverage = 0;
+        for (uint32_t s = 0; s < MSAA_SAMPLE_COUNT; ++s)
+        {
+            if (!DepthTestPasses(func, z, depth[s]))
+                continue;
+            if (depthWrite)
+                depth[s] = z;
+            coverage |= 1 << s;
+        }
+        if (coverage)
+        {
+            __m128 rgba[4] = {_mm_set1_ps(color.x), _mm_set1_ps(color.y), _mm_set1_ps(color.z), _mm_set1_ps(color.w)};
+            rt->write_quad_samples(x, y, rgba, coverage);
+        }
+        return;
+    }
+
+    DepthBuffer& depth = m_DeviceContext.GetDepthTarget() ? *m_DeviceContext.GetDepthTarget() : m_depthBuffer;
+    if (DepthTestPasses(func, z, depth.at(idx)))
+    {
+        if (depthWrite)
+            depth.at(idx) = z;
         rt->set_pixel(int2(x, y), color);
     }
 }
 
 void Device::DrawLine(int x0, int y0, int x1, int y1, float z0, float z1, const float4& color)
+{
+    drawLine(x0, y0, x1, y1, z0, z1, color, int2(INT_MIN, INT_MIN), int2(INT_MAX, INT_MAX));
+}
+
+void Device::drawLine(int x0, int y0, int x1, int y1, float z0, float z1, const float4& color, int2 clipMin,
+                      int2 clipMax)
 {
     //      
     int dx = std::abs(x1 - x0);
@@ -31,7 +66,8 @@ void Device::DrawLine(int x0, int y0, int x1, int y1, float z0, float z1, const
     int x = x0, y = y0;
     for (int i = 0; i <= steps; ++i)
     {
-        DrawPoint(x, y, z, color);
+        if (x >= clipMin.x && x <= clipMax.x && y >= clipMin.y && y <= clipMax.y)
+            DrawPoint(x, y, z, color);
         int e2 = 2 * err;
         if (e2 >= dy)
         {
@@ -47,9 +83,9 @@ void Device::DrawLine(int x0, int y0, int x1, int y1, float z0, float z1, const
     }
 }
 
-float4 Device::ClipToScreen(const float4& clipPos) const
+float4 Device::ClipToScreen(const float4& clipPos, uint32_t viewport) const
 {
-    Viewport vp = m_DeviceContext.GetViewport(); //  
+    Viewport vp = m_DeviceContext.GetViewport(viewport); //  
 
     //     SSE
     __m128 pos = clipPos.v;
@@ -88,286 +124,33 @@ VertexOutput Interpolate(const VertexOutput& v0, const VertexOutput& v1, const V
     return result;
 }
 
-void Device::RasterizeTriangle(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2)
+//     -         
+void Device::RasterizeTriangle(const int3& tri)
 {
     IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
     if (!rt) return;
-    int width = rt->width();
-    int height = rt->height();
-
-    // 1.  bounding box 
-    float minX = std::min({v0.Position.x, v1.Position.x, v2.Position.x});
-    float maxX = std::max({v0.Position.x, v1.Position.x, v2.Position.x});
-    float minY = std::min({v0.Position.y, v1.Position.y, v2.Position.y});
-    float maxY = std::max({v0.Position.y, v1.Position.y, v2.Position.y});
-
-    //    
-    int iMinX = std::max(0, (int)std::floor(minX));
-    int iMaxX = std::min(width - 1, (int)std::ceil(maxX));
-    int iMinY = std::max(0, (int)std::floor(minY));
-    int iMaxY = std::min(height - 1, (int)std::ceil(maxY));
-
-    // 2.    ()
-    float area2 = edgeFunction(v0.Position, v1.Position, v2.Position);
-
-    CullMode cull = m_DeviceContext.GetCullMode();
-    if (cull == CullMode::Back && area2 < 0)
-        return;
-    if (cull == CullMode::Front && area2 > 0)
-        return;
-
-    if (std::abs(area2) < 1e-6f)
-        return; //  
-
-    auto ps = m_DeviceContext.GetPixelShader();
-    auto cb = m_DeviceContext.GetConstantBuffer();
+    (void)RasterizeTriangleTile(tri, int2(0, 0), int2(rt->width() - 1, rt->height() - 1));
+}
 
-    // 3.     bounding box
-    for (int y = iMinY; y <= iMaxY; ++y)
+uint64_t Device::RasterizeTriangleSSE(const int3& tri)
+{
+    int2 rectMin(0, 0), rectMax = m_targetSize - int2(1, 1);
+    if (m_clipTriangles)
     {
-        for (int x = iMinX; x <= iMaxX; ++x)
-        {
-            //   (  )
-            float2 p((float)x + 0.5f, (float)y + 0.5f);
-
-            //     edge-
-            float f0 = edgeFunction(v1.Position, v2.Position, p);
-            float f1 = edgeFunction(v2.Position, v0.Position, p);
-            float f2 = edgeFunction(v0.Position, v1.Position, p);
-
-            if (f0 * area2 < 0 || f1 * area2 < 0 || f2 * area2 < 0)
-                continue;
-
-            //    
-            float a = f0 / area2;
-            float b = f1 / area2;
-            float c = f2 / area2;
-
-            //  
-            float z = a * v0.Position.z + b * v1.Position.z + c * v2.Position.z;
-            float4 color = a * v0.Color + b * v1.Color + c * v2.Color;
-            float2 uv = a * v0.UV + b * v1.UV + c * v2.UV;
-
-            //  
-            int idx = y * width + x;
-            if (z < m_depthBuffer.at(idx))
-            {
-                m_depthBuffer.at(idx) = z;
-
-                //  VertexOutput   
-                VertexOutput frag;
-                frag.Position = float4((float)x, (float)y, z, 1.0f);
-                frag.Color = color;
-                frag.UV = uv;
-
-                //   
-                float4 finalColor = ps(frag, cb);
-
-                //   
-                rt->set_pixel(int2(x, y), finalColor);
-            }
-        }
+        clipToViewport(triangleViewport(tri), rectMin, rectMax);
+        if (rectMin.x > rectMax.x || rectMin.y > rectMax.y)
+            return 0;
     }
+    if (m_depthOnly)
+        return RasterizeTriangleTileDepth(tri, rectMin, rectMax);
+    if (!m_DeviceContext.GetRenderTarget()) return 0;
+    return RasterizeTriangleTileSSE(tri, rectMin, rectMax);
 }
 
-void Device::RasterizeTriangleSSE(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2)
+void Device::clipToViewport(uint32_t viewport, int2& rectMin, int2& rectMax) const
 {
-    IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
-    if (!rt) return;
-    int width = rt->width();
-    int height = rt->height();
-
-    // Bounding box 
-    float minX = std::min({v0.Position.x, v1.Position.x, v2.Position.x});
-    float maxX = std::max({v0.Position.x, v1.Position.x, v2.Position.x});
-    float minY = std::min({v0.Position.y, v1.Position.y, v2.Position.y});
-    float maxY = std::max({v0.Position.y, v1.Position.y, v2.Position.y});
-
-    int iMinX = std::max(0, (int)std::floor(minX));
-    int iMaxX = std::min(width - 1, (int)std::ceil(maxX));
-    int iMinY = std::max(0, (int)std::floor(minY));
-    int iMaxY = std::min(height - 1, (int)std::ceil(maxY));
-
-    //   ()
-    float area2 = edgeFunction(v0.Position, v1.Position, v2.Position);
-
-    CullMode cull = m_DeviceContext.GetCullMode();
-    if (cull == CullMode::Back && area2 < 0)
-        return;
-    if (cull == CullMode::Front && area2 > 0)
-        return;
-    if (std::abs(area2) < 1e-6f)
-        return;
-
-    auto ps = m_DeviceContext.GetPixelShader();
-    auto cb = m_DeviceContext.GetConstantBuffer();
-
-    //    edge-
-    float4 dx01_ = v1.Position - v0.Position;
-    float4 dx12_ = v2.Position - v1.Position;
-    float4 dx20_ = v0.Position - v2.Position;
-
-    //       
-    __m128 v0x = _mm_set1_ps(v0.Position.x);
-    __m128 v0y = _mm_set1_ps(v0.Position.y);
-    __m128 v1x = _mm_set1_ps(v1.Position.x);
-    __m128 v1y = _mm_set1_ps(v1.Position.y);
-    __m128 v2x = _mm_set1_ps(v2.Position.x);
-    __m128 v2y = _mm_set1_ps(v2.Position.y);
-
-    __m128 v0z = _mm_set1_ps(v0.Position.z);
-    __m128 v1z = _mm_set1_ps(v1.Position.z);
-    __m128 v2z = _mm_set1_ps(v2.Position.z);
-
-    //  ()
-    __m128 v0cr = _mm_set1_ps(v0.Color.x);
-    __m128 v0cg = _mm_set1_ps(v0.Color.y);
-    __m128 v0cb = _mm_set1_ps(v0.Color.z);
-    __m128 v0ca = _mm_set1_ps(v0.Color.w);
-
-    __m128 v1cr = _mm_set1_ps(v1.Color.x);
-    __m128 v1cg = _mm_set1_ps(v1.Color.y);
-    __m128 v1cb = _mm_set1_ps(v1.Color.z);
-    __m128 v1ca = _mm_set1_ps(v1.Color.w);
-
-    __m128 v2cr = _mm_set1_ps(v2.Color.x);
-    __m128 v2cg = _mm_set1_ps(v2.Color.y);
-    __m128 v2cb = _mm_set1_ps(v2.Color.z);
-    __m128 v2ca = _mm_set1_ps(v2.Color.w);
-
-    // UV
-    __m128 v0u = _mm_set1_ps(v0.UV.x);
-    __m128 v0v = _mm_set1_ps(v0.UV.y);
-    __m128 v1u = _mm_set1_ps(v1.UV.x);
-    __m128 v1v = _mm_set1_ps(v1.UV.y);
-    __m128 v2u = _mm_set1_ps(v2.UV.x);
-    __m128 v2v = _mm_set1_ps(v2.UV.y);
-
-    //   ( )
-    __m128 invArea = _mm_set1_ps(1.0f / area2);
-
-    //   edge-
-    __m128 dx01v = _mm_set1_ps(dx01_.x);
-    __m128 dy01v = _mm_set1_ps(dx01_.y);
-    __m128 dx12v = _mm_set1_ps(dx12_.x);
-    __m128 dy12v = _mm_set1_ps(dx12_.y);
-    __m128 dx20v = _mm_set1_ps(dx20_.x);
-    __m128 dy20v = _mm_set1_ps(dx20_.y);
-
-    //   
-    for (int y = iMinY; y <= iMaxY; ++y)
-    {
-        //   y      ()
-        __m128 baseY = _mm_set1_ps(y + 0.5f);
-
-        //      4 
-        for (int x = iMinX; x <= iMaxX; x += 4)
-        {
-            //     ,   
-            int blockWidth = std::min(4, iMaxX - x + 1);
-            if (blockWidth < 4)
-            {
-                //       ,    
-                //        
-                continue;
-            }
-
-            //   4 : x+0.5, x+1+0.5, x+2+0.5, x+3+0.5
-            __m128 baseX = _mm_set_ps(x + 3.5f, x + 2.5f, x + 1.5f, x + 0.5f);
-
-            //  edge-
-            __m128 f01 =
-                _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v0x), dy01v), _mm_mul_ps(_mm_sub_ps(baseY, v0y), dx01v));
-            __m128 f12 =
-                _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v1x), dy12v), _mm_mul_ps(_mm_sub_ps(baseY, v1y), dx12v));
-            __m128 f20 =
-                _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v2x), dy20v), _mm_mul_ps(_mm_sub_ps(baseY, v2y), dx20v));
-
-            //    (   )
-            __m128 zero = _mm_setzero_ps();
-            __m128 maskInside;
-            if (area2 > 0)
-            {
-                maskInside =
-                    _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(f01, zero), _mm_cmpge_ps(f12, zero)), _mm_cmpge_ps(f20, zero));
-            }
-            else
-            {
-                maskInside =
-                    _mm_and_ps(_mm_and_ps(_mm_cmple_ps(f01, zero), _mm_cmple_ps(f12, zero)), _mm_cmple_ps(f20, zero));
-            }
-            int insideMask = _mm_movemask_ps(maskInside);
-            if (insideMask == 0)
-                continue;
-
-            //   (alpha  v1,v2, beta  v2,v0, gamma  v0,v1)
-            __m128 alpha = _mm_mul_ps(f12, invArea); //  v0?   ,     1
-            __m128 beta = _mm_mul_ps(f20, invArea);
-            __m128 gamma = _mm_mul_ps(f01, invArea);
-
-            //  
-            __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0z), _mm_mul_ps(beta, v1z)), _mm_mul_ps(gamma, v2z));
-
-            //   ()
-            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cr), _mm_mul_ps(beta, v1cr)), _mm_mul_ps(gamma, v2cr));
-            __m128 g = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cg), _mm_mul_ps(beta, v1cg)), _mm_mul_ps(gamma, v2cg));
-            __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cb), _mm_mul_ps(beta, v1cb)), _mm_mul_ps(gamma, v2cb));
-            __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0ca), _mm_mul_ps(beta, v1ca)), _mm_mul_ps(gamma, v2ca));
-
-            //  UV
-            __m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0u), _mm_mul_ps(beta, v1u)), _mm_mul_ps(gamma, v2u));
-            __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0v), _mm_mul_ps(beta, v1v)), _mm_mul_ps(gamma, v2v));
-
-            //      ( )
-            int idx0 = y * width + x;
-            __m128 depths = _mm_loadu_ps(&m_depthBuffer.at(idx0)); // ,  at  
-
-            //   (z < depths)
-            __m128 depthCmp = _mm_cmplt_ps(z, depths);
-            int depthMask = _mm_movemask_ps(depthCmp) & insideMask;
-            if (depthMask == 0)
-                continue;
-
-            //        
-            //    
-            float zArr[4], rArr[4], gArr[4], bArr[4], aArr[4], uArr[4], vArr[4];
-            _mm_storeu_ps(zArr, z);
-            _mm_storeu_ps(rArr, r);
-            _mm_storeu_ps(gArr, g);
-            _mm_storeu_ps(bArr, b);
-            _mm_storeu_ps(aArr, a);
-            _mm_storeu_ps(uArr, u);
-            _mm_storeu_ps(vArr, v);
-
-            //   4 
-            for (int i = 0; i < 4; ++i)
-            {
-                int bit = 1 << i;
-                if (depthMask & bit)
-                {
-                    //  
-                    int px = x + i;
-                    int py = y;
-                    int idx = py * width + px;
-
-                    //   
-                    m_depthBuffer.at(idx) = zArr[i];
-
-                    //  VertexOutput  
-                    VertexOutput frag;
-                    frag.Position = float4((float)px, (float)py, zArr[i], 1.0f);
-                    frag.Color = float4(rArr[i], gArr[i], bArr[i], aArr[i]);
-                    frag.UV = float2(uArr[i], vArr[i]);
-
-                    //   
-                    float4 finalColor = ps(frag, cb);
-
-                    //   
-                    rt->set_pixel(int2(px, py), finalColor);
-                }
-            }
-        }
-    }
+    rectMin = max(rectMin, m_clipMin[viewport]);
+    rectMax = min(rectMax, m_clipMax[viewport]);
 }
 
 SOFTX_END
@@ -6,53 +6,73 @@ SOFTX_BEGIN
 
 // ==========      ==========
 
-void Device::buildTiles(int width, int height)
+void Device::buildTiles(int2 areaMin, int2 areaMax)
 {
     m_tiles.clear();
     int tileSize = m_DeviceContext.GetTileSize();   //    
-    int tilesX = (width + tileSize - 1) / tileSize;
-    int tilesY = (height + tileSize - 1) / tileSize;
-    for (int ty = 0; ty < tilesY; ++ty)
+    //   (   ) -   
+    m_tileGridMin = int2(areaMin.x / tileSize, areaMin.y / tileSize);
+    m_tileGridMax = int2(areaMax.x / tileSize, areaMax.y / tileSize);
+    if (areaMin.x > areaMax.x || areaMin.y > areaMax.y)
+        m_tileGridMax = m_tileGridMin - int2(1, 1);
+    for (int ty = m_tileGridMin.y; ty <= m_tileGridMax.y; ++ty)
     {
-        for (int tx = 0; tx < tilesX; ++tx)
+        for (int tx = m_tileGridMin.x; tx <= m_tileGridMax.x; ++tx)
         {
-            int2 min(tx * tileSize, ty * tileSize);
-            int2 max(std::min((tx + 1) * tileSize - 1, width - 1),
-                     std::min((ty + 1) * tileSize - 1, height - 1));
+            //     
+            int2 min(std::max(tx * tileSize, areaMin.x), std::max(ty * tileSize, areaMin.y));
+            int2 max(std::min((tx + 1) * tileSize - 1, areaMax.x),
+                     std::min((ty + 1) * tileSize - 1, areaMax.y));
             m_tiles.emplace_back(min, max);
         }
     }
+    m_tileSamples.resize(m_tiles.size());
 }
 
-void Device::binTriangles(const std::vector<VertexOutput>& verts, const std::vector<int3>& triangles)
+void Device::binTriangles(const TransformedVertices& verts, const std::vector<int3>& triangles)
 {
     //      
     for (auto& tile : m_tiles)
         tile.triangleIndices.clear();
 
     int tileSize = m_DeviceContext.GetTileSize();
-    IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
-    if (!rt) return;   //     
-    int rtWidth = rt->width();
-    int rtHeight = rt->height();
+    int tilesX = m_tileGridMax.x - m_tileGridMin.x + 1;
+    m_smallTriangles.resize(triangles.size());
 
     for (int triIdx = 0; triIdx < (int)triangles.size(); ++triIdx)
     {
         const auto& tri = triangles[triIdx];
-        const VertexOutput& v0 = verts[tri.x];
-        const VertexOutput& v1 = verts[tri.y];
-        const VertexOutput& v2 = verts[tri.z];
-
-        float minX = std::min({v0.Position.x, v1.Position.x, v2.Position.x});
-        float maxX = std::max({v0.Position.x, v1.Position.x, v2.Position.x});
-        float minY = std::min({v0.Position.y, v1.Position.y, v2.Position.y});
-        float maxY = std::max({v0.Position.y, v1.Position.y, v2.Position.y});
+        const float4& p0 = verts.Positions[tri.x];
+        const float4& p1 = verts.Positions[tri.y];
+        const float4& p2 = verts.Positions[tri.z];
+
+        float minX = std::min({p0.x, p1.x, p2.x});
+        float maxX = std::max({p0.x, p1.x, p2.x});
+        float minY = std::min({p0.y, p1.y, p2.y});
+        float maxY = std::max({p0.y, p1.y, p2.y});
+
+        //    ;   -     
+        int tileX0 = std::max(m_tileGridMin.x, (int)(minX / tileSize));
+        int tileY0 = std::max(m_tileGridMin.y, (int)(minY / tileSize));
+        int tileX1 = std::min((int)(maxX / tileSize), m_tileGridMax.x);
+        int tileY1 = std::min((int)(maxY / tileSize), m_tileGridMax.y);
+        if (m_clipTriangles)
+        {
+            uint32_t viewport = triangleViewport(tri);
+            tileX0 = std::max(tileX0, m_clipMin[viewport].x / tileSize);
+            tileY0 = std::max(tileY0, m_clipMin[viewport].y / tileSize);
+            tileX1 = std::min(tileX1, m_clipMax[viewport].x / tileSize);
+            tileY1 = std::min(tileY1, m_clipMax[viewport].y / tileSize);
+        }
 
-        //    
-        int tileX0 = std::max(0, (int)(minX / tileSize));
-        int tileY0 = std::max(0, (int)(minY / tileSize));
-        int tileX1 = std::min((int)(maxX / tileSize), (rtWidth - 1) / tileSize);
-        int tileY1 = std::min((int)(maxY / tileSize), (rtHeight - 1) / tileSize);
+        //  :  bbox    8x8,    2x2
+        int pixMinX = (int)std::ceil(minX - 0.5f);
+        int pixMinY = (int)std::ceil(minY - 0.5f);
+        //          -  MSAA
+        //       
+        m_smallTriangles[triIdx] = m_sampleCount == 1 && !m_depthOnly &&
+                                   (int)std::floor(maxX - 0.5f) - (pixMinX & ~1) < SMALL_TRIANGLE_BLOCK &&
+                                   (int)std::floor(maxY - 0.5f) - (pixMinY & ~1) < SMALL_TRIANGLE_BLOCK;
 
 #ifdef DEBUG_TILES
         if (triIdx < 5)
@@ -68,11 +88,8 @@ void Device::binTriangles(const std::vector<VertexOutput>& verts, const std::vec
         {
             for (int tx = tileX0; tx <= tileX1; ++tx)
             {
-                int tileIdx = ty * ((rtWidth + tileSize - 1) / tileSize) + tx;
-                if (tileIdx < (int)m_tiles.size())
-                {
-                    m_tiles[tileIdx].triangleIndices.push_back(triIdx);
-                }
+                int tileIdx = (ty - m_tileGridMin.y) * tilesX + (tx - m_tileGridMin.x);
+                m_tiles[tileIdx].triangleIndices.push_back(triIdx);
             }
         }
     }
@@ -108,294 +125,1096 @@ void Device::renderTilesSingleThreaded()
     }
 }
 
-void Device::RasterizeTriangleTile(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2, int2 tileMin, int2 tileMax)
+// ==========     ==========
+
+namespace
+{
+//     1/256 ,     :
+//      ,       
+constexpr int SUBPIXEL_BITS = 8;
+constexpr int SUBPIXEL_HALF = 1 << (SUBPIXEL_BITS - 1);
+//     ( )   ,   int64
+constexpr float SUBPIXEL_GUARD = float(1 << 21);
+//     int32,          
+//   ;     int64
+constexpr int64_t EDGE_NARROW_STEP = int64_t(1) << 28;
+constexpr int64_t EDGE_NARROW_LIMIT = int64_t(1) << 30;
+
+int64_t snapSubpixel(float v)
+{
+    // NaN    
+    v = v > -SUBPIXEL_GUARD ? (v < SUBPIXEL_GUARD ? v : SUBPIXEL_GUARD) : -SUBPIXEL_GUARD;
+    return (int64_t)std::floor(v * (float)(1 << SUBPIXEL_BITS) + 0.5f);
+}
+
+//      ;    int32
+__m128i snapSubpixel4(__m128 v)
+{
+    // _mm_max_ps   ,   - NaN
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-SUBPIXEL_GUARD)), _mm_set1_ps(SUBPIXEL_GUARD));
+    return _mm_cvttps_epi32(
+        _mm_floor_ps(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps((float)(1 << SUBPIXEL_BITS))), _mm_set1_ps(0.5f))));
+}
+
+//    ,     ( )   
+int pixelCeil(int64_t v)
+{
+    return (int)((v - SUBPIXEL_HALF + (1 << SUBPIXEL_BITS) - 1) >> SUBPIXEL_BITS);
+}
+int pixelFloor(int64_t v)
+{
+    return (int)((v - SUBPIXEL_HALF) >> SUBPIXEL_BITS);
+}
+
+int32_t clampEdge(int64_t e, int64_t limit)
+{
+    return (int32_t)std::max(-limit, std::min(e, limit));
+}
+
+//   2x2     (x, y),   bbox.  (  SIMD):
+// 0 - (x, y), 1 - (x + 1, y), 2 - (x, y + 1), 3 - (x + 1, y + 1).    bbox     
+int quadMask(int x, int y, int minX, int maxX, int minY, int maxY)
+{
+    int mask = 0xF;
+    if (x < minX) mask &= 0xA;
+    if (x + 1 > maxX) mask &= 0x5;
+    if (y < minY) mask &= 0xC;
+    if (y + 1 > maxY) mask &= 0x3;
+    return mask;
+}
+
+//  E(x, y) = A * x + B * y + C    (x, y),     .
+//  ,  E >= 0    ; C     top-left
+struct EdgeEquation
+{
+    int64_t A, B, C;
+    int64_t Bias; // 0 -     (   ), -1 - 
+
+    int64_t Evaluate(int x, int y) const
+    {
+        return A * x + B * y + C;
+    }
+};
+
+struct TriangleSetup
+{
+    EdgeEquation Edge[3];       // Edge[i] -    i, (E - Bias) / Area -  
+    int64_t Area;               //  , > 0
+    float InvArea;
+    int MinX, MaxX, MinY, MaxY; // ,     bbox
+};
+
+//   a  b; flip -     ,  ,
+//     ,  E > 0
+EdgeEquation setupEdge(int64_t xa, int64_t ya, int64_t xb, int64_t yb, bool flip)
+{
+    int64_t dx = xb - xa, dy = yb - ya;
+    EdgeEquation e;
+    e.A = dy * (1 << SUBPIXEL_BITS);
+    e.B = -dx * (1 << SUBPIXEL_BITS);
+    e.C = (SUBPIXEL_HALF - xa) * dy - (SUBPIXEL_HALF - ya) * dx;
+    if (flip)
+    {
+        e.A = -e.A;
+        e.B = -e.B;
+        e.C = -e.C;
+    }
+    //   -   (A > 0),  -    
+    bool topLeft = e.A > 0 || (e.A == 0 && e.B > 0);
+    e.Bias = topLeft ? 0 : -1;
+    e.C += e.Bias;
+    return e;
+}
+
+// false -          CullMode.
+// expand ( )  bbox:  MSAA       
+bool setupTriangle(const float4& p0, const float4& p1, const float4& p2, CullMode cull, TriangleSetup& s,
+                   int64_t expand = 0)
+{
+    int64_t x0 = snapSubpixel(p0.x), y0 = snapSubpixel(p0.y);
+    int64_t x1 = snapSubpixel(p1.x), y1 = snapSubpixel(p1.y);
+    int64_t x2 = snapSubpixel(p2.x), y2 = snapSubpixel(p2.y);
+
+    int64_t area = (x2 - x0) * (y1 - y0) - (y2 - y0) * (x1 - x0);
+    if (area == 0)
+        return false;
+    if (cull == CullMode::Back && area < 0) return false;
+    if (cull == CullMode::Front && area > 0) return false;
+
+    bool flip = area < 0;
+    s.Edge[0] = setupEdge(x1, y1, x2, y2, flip);
+    s.Edge[1] = setupEdge(x2, y2, x0, y0, flip);
+    s.Edge[2] = setupEdge(x0, y0, x1, y1, flip);
+    s.Area = flip ? -area : area;
+    s.InvArea = 1.0f / (float)s.Area;
+
+    s.MinX = pixelCeil(std::min({x0, x1, x2}) - expand);
+    s.MaxX = pixelFloor(std::max({x0, x1, x2}) + expand);
+    s.MinY = pixelCeil(std::min({y0, y1, y2}) - expand);
+    s.MaxY = pixelFloor(std::max({y0, y1, y2}) + expand);
+    return true;
+}
+
+//   varyings     : a0 + w1 * (a1 - a0) + w2 * (a2 - a0)
+struct TrianglePlanes
+{
+    __m128 Z[3];
+    __m128 A0[MAX_VARYINGS], A10[MAX_VARYINGS], A20[MAX_VARYINGS];
+    uint32_t Count;
+};
+
+void loadTrianglePlanes(TrianglePlanes& planes, const TransformedVertices& verts, const int3& tri, uint32_t varyingCount)
+{
+    planes.Z[0] = _mm_set1_ps(verts.Positions[tri.x].z);
+    planes.Z[1] = _mm_set1_ps(verts.Positions[tri.y].z);
+    planes.Z[2] = _mm_set1_ps(verts.Positions[tri.z].z);
+    planes.Count = varyingCount;
+    for (uint32_t k = 0; k < varyingCount; ++k)
+    {
+        const float* comp = verts.Varying(k);
+        planes.A0[k] = _mm_set1_ps(comp[tri.x]);
+        planes.A10[k] = _mm_set1_ps(comp[tri.y] - comp[tri.x]);
+        planes.A20[k] = _mm_set1_ps(comp[tri.z] - comp[tri.x]);
+    }
+}
+
+//  ,   
+__m128 depthCompare(DepthFunc func, __m128 z, __m128 depth)
+{
+    switch (func)
+    {
+    case DepthFunc::Never: return _mm_setzero_ps();
+    case DepthFunc::Less: return _mm_cmplt_ps(z, depth);
+    case DepthFunc::Equal: return _mm_cmpeq_ps(z, depth);
+    case DepthFunc::LessEqual: return _mm_cmple_ps(z, depth);
+    case DepthFunc::Greater: return _mm_cmpgt_ps(z, depth);
+    case DepthFunc::NotEqual: return _mm_cmpneq_ps(z, depth);
+    case DepthFunc::GreaterEqual: return _mm_cmpge_ps(z, depth);
+    default: return _mm_castsi128_ps(_mm_set1_epi32(-1));
+    }
+}
+
+//       
+struct PixelTarget
+{
+    float* Depth;
+    int Width, Height;
+    const QuadPixelProgram* Program;
+    ConstantBuffer CB;
+    const SamplerState* Samplers;
+    DepthFunc Func;
+    bool DepthWrite;
+};
+
+//        mask  2x2     (x, y).
+// Varyings     ,     (helper lanes):
+//    ,    .  ,    
+int shadeQuad(const PixelTarget& target, const TrianglePlanes& planes, const __m128 w[3], int mask, int x, int y,
+              PixelQuadOutput& color)
+{
+    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], planes.Z[0]), _mm_mul_ps(w[1], planes.Z[1])),
+                          _mm_mul_ps(w[2], planes.Z[2]));
+
+    float* depth = target.Depth + (size_t)y * target.Width + x;
+    __m128 depths;
+    if (x + 2 <= target.Width && y + 2 <= target.Height)
+        depths = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)depth), (const __m64*)(depth + target.Width));
+    else
+    {
+        //     -     (   mask)
+        alignas(16) float edge[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (int i = 0; i < 4; ++i)
+            if (mask & (1 << i))
+                edge[i] = depth[(i >> 1) * target.Width + (i & 1)];
+        depths = _mm_load_ps(edge);
+    }
+    int depthMask = _mm_movemask_ps(depthCompare(target.Func, z, depths)) & mask;
+    if (depthMask == 0)
+        return 0;
+
+    //  varyings -    
+    PixelQuadInput quad;
+    quad.X = _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f));
+    quad.Y = _mm_add_ps(_mm_set1_ps((float)y), _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f));
+    quad.Z = z;
+    quad.Mask = depthMask;
+    quad.Samplers = target.Samplers;
+    alignas(16) float vary[4];
+    for (uint32_t k = 0; k < planes.Count; ++k)
+    {
+        quad.Attributes[k] = _mm_add_ps(planes.A0[k], _mm_add_ps(_mm_mul_ps(w[1], planes.A10[k]),
+                                                                  _mm_mul_ps(w[2], planes.A20[k])));
+        _mm_store_ps(vary, quad.Attributes[k]);
+        quad.Ddx.v[k] = vary[1] - vary[0];
+        quad.Ddy.v[k] = vary[2] - vary[0];
+    }
+
+    if (target.DepthWrite)
+    {
+        alignas(16) float zArr[4];
+        _mm_store_ps(zArr, z);
+        for (int i = 0; i < 4; ++i)
+            if (depthMask & (1 << i))
+                depth[(i >> 1) * target.Width + (i & 1)] = zArr[i];
+    }
+
+    (*target.Program)(quad, color, target.CB);
+    return depthMask;
+}
+
+//    MSAA      (6/16 )
+constexpr int64_t MSAA_SAMPLE_REACH = 6 << (SUBPIXEL_BITS - 4);
+
+//       ->   i * 4 (   )
+constexpr uint16_t SAMPLE_COVERAGE_SPREAD[16] = {0x0000, 0x0001, 0x0010, 0x0011, 0x0100, 0x0101, 0x0110, 0x0111,
+                                                 0x1000, 0x1001, 0x1010, 0x1011, 0x1100, 0x1101, 0x1110, 0x1111};
+
+//  ,        (coverage -  i * 4 + s)
+int coveredPixels(int coverage)
+{
+    int mask = 0;
+    for (int i = 0; i < 4; ++i)
+        if (coverage & (0xF << (i * 4)))
+            mask |= 1 << i;
+    return mask;
+}
+
+//      (samples -  , zs -  ).
+//   ;  write   
+int testSampleDepth(float* depth, __m128 zs, int samples, DepthFunc func, bool write)
+{
+    static const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+    if (samples == 0)
+        return 0;
+    __m128 depths = _mm_loadu_ps(depth);
+    int pass = _mm_movemask_ps(depthCompare(func, zs, depths)) & samples;
+    if (pass == 0 || !write)
+        return pass;
+    __m128 passMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(pass), bits), bits));
+    _mm_storeu_ps(depth, _mm_blendv_ps(depths, zs, passMask));
+    return pass;
+}
+
+//  shadeQuad,        (target.Depth - 
+// MSAA_SAMPLE_COUNT   , zOffset -      ).
+//      , varyings -   .   
+int shadeQuadMultisample(const PixelTarget& target, const TrianglePlanes& planes, const __m128 w[3], int coverage,
+                         int x, int y, __m128 zOffset, PixelQuadOutput& color)
+{
+    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], planes.Z[0]), _mm_mul_ps(w[1], planes.Z[1])),
+                          _mm_mul_ps(w[2], planes.Z[2]));
+
+    //     :  (x, x + 1)   y     y + 1
+    float* row0 = target.Depth + ((size_t)y * target.Width + x) * MSAA_SAMPLE_COUNT;
+    float* row1 = row0 + (size_t)target.Width * MSAA_SAMPLE_COUNT;
+    DepthFunc func = target.Func;
+    bool write = target.DepthWrite;
+    int passed =
+        testSampleDepth(row0, _mm_add_ps(_mm_shuffle_ps(z, z, 0x00), zOffset), coverage & 0xF, func, write);
+    passed |= testSampleDepth(row0 + MSAA_SAMPLE_COUNT, _mm_add_ps(_mm_shuffle_ps(z, z, 0x55), zOffset),
+                              (coverage >> 4) & 0xF, func, write) << 4;
+    passed |= testSampleDepth(row1, _mm_add_ps(_mm_shuffle_ps(z, z, 0xAA), zOffset), (coverage >> 8) & 0xF, func,
+                              write) << 8;
+    passed |= testSampleDepth(row1 + MSAA_SAMPLE_COUNT, _mm_add_ps(_mm_shuffle_ps(z, z, 0xFF), zOffset),
+                              (coverage >> 12) & 0xF, func, write) << 12;
+    if (passed == 0)
+        return 0;
+
+    PixelQuadInput quad;
+    quad.X = _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f));
+    quad.Y = _mm_add_ps(_mm_set1_ps((float)y), _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f));
+    quad.Z = z;
+    quad.Mask = coveredPixels(passed);
+    quad.Samplers = target.Samplers;
+    alignas(16) float vary[4];
+    for (uint32_t k = 0; k < planes.Count; ++k)
+    {
+        quad.Attributes[k] = _mm_add_ps(planes.A0[k], _mm_add_ps(_mm_mul_ps(w[1], planes.A10[k]),
+                                                                  _mm_mul_ps(w[2], planes.A20[k])));
+        _mm_store_ps(vary, quad.Attributes[k]);
+        quad.Ddx.v[k] = vary[1] - vary[0];
+        quad.Ddy.v[k] = vary[2] - vary[0];
+    }
+
+    (*target.Program)(quad, color, target.CB);
+    return passed;
+}
+
+//          (z -   shadeQuad).
+//     
+int writeQuadDepth(float* depthBuffer, int width, int height, __m128 z, int mask, int x, int y, DepthFunc func,
+                   bool write)
+{
+    float* depth = depthBuffer + (size_t)y * width + x;
+    if (mask == 0xF && x + 2 <= width && y + 2 <= height)
+    {
+        __m128 depths = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)depth), (const __m64*)(depth + width));
+        __m128 pass = depthCompare(func, z, depths);
+        if (write)
+        {
+            __m128 result = _mm_blendv_ps(depths, z, pass);
+            _mm_storel_pi((__m64*)depth, result);
+            _mm_storeh_pi((__m64*)(depth + width), result);
+        }
+        return _mm_popcnt_u32(_mm_movemask_ps(pass));
+    }
+
+    //  :   mask    ,   
+    alignas(16) float zArr[4];
+    _mm_store_ps(zArr, z);
+    int passed = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!(mask & (1 << i)))
+            continue;
+        float& d = depth[(i >> 1) * width + (i & 1)];
+        if (!DepthTestPasses(func, zArr[i], d))
+            continue;
+        ++passed;
+        if (write)
+            d = zArr[i];
+    }
+    return passed;
+}
+} // namespace
+
+uint64_t Device::RasterizeTriangleTile(const int3& tri, int2 tileMin, int2 tileMax)
 {
     IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
-    if (!rt) return;
+    if (!rt) return 0;
     int width = rt->width();
-    int height = rt->height();
 
-    // Bounding box 
-    float minX = std::min({v0.Position.x, v1.Position.x, v2.Position.x});
-    float maxX = std::max({v0.Position.x, v1.Position.x, v2.Position.x});
-    float minY = std::min({v0.Position.y, v1.Position.y, v2.Position.y});
-    float maxY = std::max({v0.Position.y, v1.Position.y, v2.Position.y});
+    const float4& p0 = m_transformedVerts.Positions[tri.x];
+    const float4& p1 = m_transformedVerts.Positions[tri.y];
+    const float4& p2 = m_transformedVerts.Positions[tri.z];
 
-    //   
-    int iMinX = std::max((int)std::ceil(minX), tileMin.x);
-    int iMaxX = std::min((int)std::floor(maxX), tileMax.x);
-    int iMinY = std::max((int)std::ceil(minY), tileMin.y);
-    int iMaxY = std::min((int)std::floor(maxY), tileMax.y);
+    TriangleSetup setup;
+    if (!setupTriangle(p0, p1, p2, m_DeviceContext.GetCullMode(), setup))
+        return 0;
 
+    //   
+    int iMinX = std::max(setup.MinX, tileMin.x);
+    int iMaxX = std::min(setup.MaxX, tileMax.x);
+    int iMinY = std::max(setup.MinY, tileMin.y);
+    int iMaxY = std::min(setup.MaxY, tileMax.y);
     if (iMinX > iMaxX || iMinY > iMaxY)
-        return;
-
-    //    culling
-    float area2 = edgeFunction(v0.Position, v1.Position, v2.Position);
-    CullMode cull = m_DeviceContext.GetCullMode();
-    if (cull == CullMode::Back && area2 < 0) return;
-    if (cull == CullMode::Front && area2 > 0) return;
-    if (std::abs(area2) < 1e-6f) return;
+        return 0;
 
-    auto ps = m_DeviceContext.GetPixelShader();
+    const QuadPixelProgram& ps = m_pixelProgram;
     auto cb = m_DeviceContext.GetConstantBuffer();
 
-    //  ()
-    for (int y = iMinY; y <= iMaxY; ++y)
+    // Varyings  : a0 + b * (a1 - a0) + c * (a2 - a0)
+    uint32_t varyingCount = m_varyingCount;
+    float attr0[MAX_VARYINGS], attr10[MAX_VARYINGS], attr20[MAX_VARYINGS];
+    for (uint32_t k = 0; k < varyingCount; ++k)
     {
-        for (int x = iMinX; x <= iMaxX; ++x)
-        {
-            float2 p((float)x + 0.5f, (float)y + 0.5f);
+        const float* comp = m_transformedVerts.Varying(k);
+        attr0[k] = comp[tri.x];
+        attr10[k] = comp[tri.y] - attr0[k];
+        attr20[k] = comp[tri.z] - attr0[k];
+    }
 
-            float f0 = edgeFunction(v1.Position, v2.Position, p);
-            float f1 = edgeFunction(v2.Position, v0.Position, p);
-            float f2 = edgeFunction(v0.Position, v1.Position, p);
+    PixelQuadInput quad;
+    quad.Samplers = m_DeviceContext.GetSamplers();
+    PixelQuadOutput color;
+    float* depthBuffer = m_depthTarget->data();
+    DepthFunc depthFunc = m_depthFunc;
+    uint64_t samples = 0;
 
-            if ((area2 > 0 && (f0 < 0 || f1 < 0 || f2 < 0)) ||
-                (area2 < 0 && (f0 > 0 || f1 > 0 || f2 > 0)))
+    //  (,  )  2x2   
+    int xFirst = iMinX & ~1, yFirst = iMinY & ~1;
+    for (int y = yFirst; y <= iMaxY; y += 2)
+    {
+        for (int x = xFirst; x <= iMaxX; x += 2)
+        {
+            int mask = quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+            int covered = 0;
+            float w[3][4];
+            for (int i = 0; i < 4; ++i)
             {
-                continue;
+                int px = x + (i & 1), py = y + (i >> 1);
+                int64_t e0 = setup.Edge[0].Evaluate(px, py);
+                int64_t e1 = setup.Edge[1].Evaluate(px, py);
+                int64_t e2 = setup.Edge[2].Evaluate(px, py);
+                if ((e0 | e1 | e2) >= 0)
+                    covered |= 1 << i;
+
+                //        -  
+                w[0][i] = (float)(e0 - setup.Edge[0].Bias) * setup.InvArea;
+                w[1][i] = (float)(e1 - setup.Edge[1].Bias) * setup.InvArea;
+                w[2][i] = (float)(e2 - setup.Edge[2].Bias) * setup.InvArea;
             }
+            covered &= mask;
+            if (covered == 0)
+                continue;
 
-            float a = f0 / area2;
-            float b = f1 / area2;
-            float c = f2 / area2;
-
-            float z = a * v0.Position.z + b * v1.Position.z + c * v2.Position.z;
-            float4 color = a * v0.Color + b * v1.Color + c * v2.Color;
-            float2 uv = a * v0.UV + b * v1.UV + c * v2.UV;
-
-            int idx = y * width + x;
-            if (z < m_depthBuffer.at(idx))
+            float z[4];
+            int passed = 0;
+            for (int i = 0; i < 4; ++i)
             {
-                m_depthBuffer.at(idx) = z;
-
-                VertexOutput frag;
-                frag.Position = float4((float)x, (float)y, z, 1.0f);
-                frag.Color = color;
-                frag.UV = uv;
+                z[i] = w[0][i] * p0.z + w[1][i] * p1.z + w[2][i] * p2.z;
+                if ((covered & (1 << i)) && DepthTestPasses(depthFunc, z[i], depthBuffer[(y + (i >> 1)) * width + x + (i & 1)]))
+                    passed |= 1 << i;
+            }
+            if (passed == 0)
+                continue;
 
-                float4 finalColor = ps(frag, cb);
-                rt->set_pixel(int2(x, y), finalColor);
+            float vary[4];
+            for (uint32_t k = 0; k < varyingCount; ++k)
+            {
+                for (int i = 0; i < 4; ++i)
+                    vary[i] = attr0[k] + (w[1][i] * attr10[k] + w[2][i] * attr20[k]);
+                quad.Attributes[k] = _mm_setr_ps(vary[0], vary[1], vary[2], vary[3]);
+                quad.Ddx.v[k] = vary[1] - vary[0];
+                quad.Ddy.v[k] = vary[2] - vary[0];
             }
+
+            for (int i = 0; i < 4; ++i)
+                if ((passed & (1 << i)) && m_depthWrite)
+                    depthBuffer[(y + (i >> 1)) * width + x + (i & 1)] = z[i];
+
+            quad.X = _mm_setr_ps((float)x, (float)(x + 1), (float)x, (float)(x + 1));
+            quad.Y = _mm_setr_ps((float)y, (float)y, (float)(y + 1), (float)(y + 1));
+            quad.Z = _mm_setr_ps(z[0], z[1], z[2], z[3]);
+            quad.Mask = passed;
+            ps(quad, color, cb);
+            writeQuad(color, passed, x, y);
+            samples += _mm_popcnt_u32(passed);
         }
     }
+    return samples;
 }
 
-void Device::RasterizeTriangleTileSSE(const VertexOutput& v0, const VertexOutput& v1, const VertexOutput& v2, int2 tileMin, int2 tileMax)
+uint64_t Device::RasterizeTriangleTileSSE(const int3& tri, int2 tileMin, int2 tileMax)
 {
+    if (m_sampleCount > 1)
+        return RasterizeTriangleTileMSAA(tri, tileMin, tileMax);
+
     IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
-    if (!rt) return;
+    if (!rt) return 0;
     int width = rt->width();
-    int height = rt->height();
 
-    // Bounding box 
-    float triMinX = std::min({v0.Position.x, v1.Position.x, v2.Position.x});
-    float triMaxX = std::max({v0.Position.x, v1.Position.x, v2.Position.x});
-    float triMinY = std::min({v0.Position.y, v1.Position.y, v2.Position.y});
-    float triMaxY = std::max({v0.Position.y, v1.Position.y, v2.Position.y});
+    const float4& p0 = m_transformedVerts.Positions[tri.x];
+    const float4& p1 = m_transformedVerts.Positions[tri.y];
+    const float4& p2 = m_transformedVerts.Positions[tri.z];
 
-    //   
-    int iMinX = std::max((int)std::ceil(triMinX), tileMin.x);
-    int iMaxX = std::min((int)std::floor(triMaxX), tileMax.x);
-    int iMinY = std::max((int)std::ceil(triMinY), tileMin.y);
-    int iMaxY = std::min((int)std::floor(triMaxY), tileMax.y);
+    TriangleSetup setup;
+    if (!setupTriangle(p0, p1, p2, m_DeviceContext.GetCullMode(), setup))
+        return 0;
 
+    //   
+    int iMinX = std::max(setup.MinX, tileMin.x);
+    int iMaxX = std::min(setup.MaxX, tileMax.x);
+    int iMinY = std::max(setup.MinY, tileMin.y);
+    int iMaxY = std::min(setup.MaxY, tileMax.y);
     if (iMinX > iMaxX || iMinY > iMaxY)
-        return;
+        return 0;
+
+    //    varyings;   varyingCount ,  
+    TrianglePlanes planes;
+    loadTrianglePlanes(planes, m_transformedVerts, tri, m_varyingCount);
+    PixelTarget target = {m_depthTarget->data(), width, rt->height(), &m_pixelProgram,
+                          m_DeviceContext.GetConstantBuffer(), m_DeviceContext.GetSamplers(), m_depthFunc, m_depthWrite};
+    PixelQuadOutput color;
+    uint64_t samples = 0;
+
+    //      (  -   quadMask)     
+    __m128i laneStep[3], quadStep[3], bias[3];
+    bool narrow = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        const EdgeEquation& edge = setup.Edge[i];
+        narrow = narrow && std::abs(edge.A) < EDGE_NARROW_STEP && std::abs(edge.B) < EDGE_NARROW_STEP;
+        int32_t a = narrow ? (int32_t)edge.A : 0;
+        int32_t b = narrow ? (int32_t)edge.B : 0;
+        laneStep[i] = _mm_setr_epi32(0, a, b, a + b);
+        quadStep[i] = _mm_set1_epi32(a * 2);
+        bias[i] = _mm_set1_epi32((int32_t)edge.Bias);
+    }
+    __m128 invArea = _mm_set1_ps(setup.InvArea);
 
-    float area2 = edgeFunction(v0.Position, v1.Position, v2.Position);
-    CullMode cull = m_DeviceContext.GetCullMode();
-    if (cull == CullMode::Back && area2 < 0) return;
-    if (cull == CullMode::Front && area2 > 0) return;
-    if (std::abs(area2) < 1e-6f) return;
+    //  2x2   :   bbox   ,
+    //    
+    int xFirst = iMinX & ~1, yFirst = iMinY & ~1;
+    int quads = (iMaxX - xFirst) / 2 + 1;
+    for (int y = yFirst; y <= iMaxY; y += 2)
+    {
+        int64_t e[3];
+        bool exact = narrow;
+        for (int i = 0; i < 3; ++i)
+        {
+            const EdgeEquation& edge = setup.Edge[i];
+            e[i] = edge.Evaluate(xFirst, y);
+            exact = exact && std::abs(e[i]) + std::abs(edge.A) * quads * 2 + std::abs(edge.B) < EDGE_NARROW_LIMIT;
+        }
 
-    auto ps = m_DeviceContext.GetPixelShader();
-    auto cb = m_DeviceContext.GetConstantBuffer();
+        if (exact)
+        {
+            //     int32:   ,  -     
+            __m128i edge[3];
+            for (int i = 0; i < 3; ++i)
+                edge[i] = _mm_add_epi32(_mm_set1_epi32((int32_t)e[i]), laneStep[i]);
+
+            for (int x = xFirst; x <= iMaxX; x += 2)
+            {
+                //  -      
+                __m128i lanes = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+                int mask = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+                if (mask)
+                {
+                    __m128 w[3];
+                    for (int i = 0; i < 3; ++i)
+                        w[i] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[i], bias[i])), invArea);
+                    if (int written = shadeQuad(target, planes, w, mask, x, y, color))
+                    {
+                        writeQuad(color, written, x, y);
+                        samples += _mm_popcnt_u32(written);
+                    }
+                }
+                for (int i = 0; i < 3; ++i)
+                    edge[i] = _mm_add_epi32(edge[i], quadStep[i]);
+            }
+            continue;
+        }
 
-    // ---------- SSE- ----------
+        //  :   int64,  int32    
+        for (int x = xFirst; x <= iMaxX; x += 2)
+        {
+            int64_t lane[3][4];
+            __m128i lanes = _mm_setzero_si128();
+            for (int i = 0; i < 3; ++i)
+            {
+                int64_t a = setup.Edge[i].A, b = setup.Edge[i].B;
+                lane[i][0] = e[i];
+                lane[i][1] = e[i] + a;
+                lane[i][2] = e[i] + b;
+                lane[i][3] = e[i] + a + b;
+                lanes = _mm_or_si128(lanes, _mm_setr_epi32(clampEdge(lane[i][0], INT32_MAX), clampEdge(lane[i][1], INT32_MAX),
+                                                           clampEdge(lane[i][2], INT32_MAX),
+                                                           clampEdge(lane[i][3], INT32_MAX)));
+            }
+            int mask = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+            if (mask)
+            {
+                //  -       top-left
+                __m128 w[3];
+                for (int i = 0; i < 3; ++i)
+                {
+                    int64_t b = setup.Edge[i].Bias;
+                    w[i] = _mm_mul_ps(_mm_setr_ps((float)(lane[i][0] - b), (float)(lane[i][1] - b),
+                                                  (float)(lane[i][2] - b), (float)(lane[i][3] - b)),
+                                      invArea);
+                }
+                if (int written = shadeQuad(target, planes, w, mask, x, y, color))
+                {
+                    writeQuad(color, written, x, y);
+                    samples += _mm_popcnt_u32(written);
+                }
+            }
+            for (int i = 0; i < 3; ++i)
+                e[i] += setup.Edge[i].A * 2;
+        }
+    }
+    return samples;
+}
+
+uint64_t Device::RasterizeTriangleTileDepth(const int3& tri, int2 tileMin, int2 tileMax)
+{
+    const float4& p0 = m_transformedVerts.Positions[tri.x];
+    const float4& p1 = m_transformedVerts.Positions[tri.y];
+    const float4& p2 = m_transformedVerts.Positions[tri.z];
+
+    TriangleSetup setup;
+    if (!setupTriangle(p0, p1, p2, m_DeviceContext.GetCullMode(), setup))
+        return 0;
+
+    int iMinX = std::max(setup.MinX, tileMin.x);
+    int iMaxX = std::min(setup.MaxX, tileMax.x);
+    int iMinY = std::max(setup.MinY, tileMin.y);
+    int iMaxY = std::min(setup.MaxY, tileMax.y);
+    if (iMinX > iMaxX || iMinY > iMaxY)
+        return 0;
+
+    //    ,   shadeQuad:    Z-prepass    
+    float* depthBuffer = m_depthTarget->data();
+    int width = m_depthTarget->width(), height = m_depthTarget->height();
+    DepthFunc func = m_depthFunc;
+    bool write = m_depthWrite;
+    uint64_t samples = 0;
+    const __m128 z0 = _mm_set1_ps(p0.z), z1 = _mm_set1_ps(p1.z), z2 = _mm_set1_ps(p2.z);
+
+    __m128i laneStep[3], quadStep[3], bias[3];
+    bool narrow = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        const EdgeEquation& edge = setup.Edge[i];
+        narrow = narrow && std::abs(edge.A) < EDGE_NARROW_STEP && std::abs(edge.B) < EDGE_NARROW_STEP;
+        int32_t a = narrow ? (int32_t)edge.A : 0;
+        int32_t b = narrow ? (int32_t)edge.B : 0;
+        laneStep[i] = _mm_setr_epi32(0, a, b, a + b);
+        quadStep[i] = _mm_set1_epi32(a * 2);
+        bias[i] = _mm_set1_epi32((int32_t)edge.Bias);
+    }
+    __m128 invArea = _mm_set1_ps(setup.InvArea);
+
+    // и,   x:        ,
+    //        
+    int decreasing = 0;
+    for (int i = 0; i < 3; ++i)
+        if (setup.Edge[i].A <= 0)
+            decreasing |= 1 << i;
+
+    int xFirst = iMinX & ~1, yFirst = iMinY & ~1;
+    for (int y = yFirst; y <= iMaxY; y += 2)
     {
-        float4 dx01 = v1.Position - v0.Position;
-        float4 dx12 = v2.Position - v1.Position;
-        float4 dx20 = v0.Position - v2.Position;
-
-        __m128 v0x = _mm_set1_ps(v0.Position.x);
-        __m128 v0y = _mm_set1_ps(v0.Position.y);
-        __m128 v1x = _mm_set1_ps(v1.Position.x);
-        __m128 v1y = _mm_set1_ps(v1.Position.y);
-        __m128 v2x = _mm_set1_ps(v2.Position.x);
-        __m128 v2y = _mm_set1_ps(v2.Position.y);
-
-        __m128 v0z = _mm_set1_ps(v0.Position.z);
-        __m128 v1z = _mm_set1_ps(v1.Position.z);
-        __m128 v2z = _mm_set1_ps(v2.Position.z);
-
-        __m128 v0cr = _mm_set1_ps(v0.Color.x);
-        __m128 v0cg = _mm_set1_ps(v0.Color.y);
-        __m128 v0cb = _mm_set1_ps(v0.Color.z);
-        __m128 v0ca = _mm_set1_ps(v0.Color.w);
-        __m128 v1cr = _mm_set1_ps(v1.Color.x);
-        __m128 v1cg = _mm_set1_ps(v1.Color.y);
-        __m128 v1cb = _mm_set1_ps(v1.Color.z);
-        __m128 v1ca = _mm_set1_ps(v1.Color.w);
-        __m128 v2cr = _mm_set1_ps(v2.Color.x);
-        __m128 v2cg = _mm_set1_ps(v2.Color.y);
-        __m128 v2cb = _mm_set1_ps(v2.Color.z);
-        __m128 v2ca = _mm_set1_ps(v2.Color.w);
-
-        __m128 v0u = _mm_set1_ps(v0.UV.x);
-        __m128 v0v = _mm_set1_ps(v0.UV.y);
-        __m128 v1u = _mm_set1_ps(v1.UV.x);
-        __m128 v1v = _mm_set1_ps(v1.UV.y);
-        __m128 v2u = _mm_set1_ps(v2.UV.x);
-        __m128 v2v = _mm_set1_ps(v2.UV.y);
-
-        __m128 invArea = _mm_set1_ps(1.0f / area2);
-
-        __m128 dx01v = _mm_set1_ps(dx01.x);
-        __m128 dy01v = _mm_set1_ps(dx01.y);
-        __m128 dx12v = _mm_set1_ps(dx12.x);
-        __m128 dy12v = _mm_set1_ps(dx12.y);
-        __m128 dx20v = _mm_set1_ps(dx20.x);
-        __m128 dy20v = _mm_set1_ps(dx20.y);
-
-        for (int y = iMinY; y <= iMaxY; ++y)
+        int64_t e[3];
+        for (int i = 0; i < 3; ++i)
+            e[i] = setup.Edge[i].Evaluate(xFirst, y);
+
+        //  : ,   x      ,
+        //       skip 
+        int64_t skip = 0;
+        for (int i = 0; i < 3; ++i)
         {
-            __m128 baseY = _mm_set1_ps(y + 0.5f);
+            const EdgeEquation& edge = setup.Edge[i];
+            int64_t top = e[i] + edge.A + std::max<int64_t>(edge.B, 0);
+            if (edge.A > 0 && top < 0)
+                skip = std::max(skip, (-top + edge.A * 2 - 1) / (edge.A * 2));
+        }
+        if (xFirst + skip * 2 > iMaxX)
+            continue;
+        int xStart = xFirst + (int)skip * 2;
+        int quads = (iMaxX - xStart) / 2 + 1;
+        bool exact = narrow;
+        for (int i = 0; i < 3; ++i)
+        {
+            const EdgeEquation& edge = setup.Edge[i];
+            e[i] += edge.A * 2 * skip;
+            exact = exact && std::abs(e[i]) + std::abs(edge.A) * quads * 2 + std::abs(edge.B) < EDGE_NARROW_LIMIT;
+        }
 
-            int xStart = iMinX;
-            int xEnd = iMaxX;
+        if (exact)
+        {
+            __m128i edge[3];
+            for (int i = 0; i < 3; ++i)
+                edge[i] = _mm_add_epi32(_mm_set1_epi32((int32_t)e[i]), laneStep[i]);
 
-            int xBlockStart = (xStart + 3) & ~3;
-            int xBlockEnd = xEnd & ~3;
+            for (int x = xStart; x <= iMaxX; x += 2)
+            {
+                __m128i lanes = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+                int mask = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+                if (mask)
+                {
+                    __m128 w0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[0], bias[0])), invArea);
+                    __m128 w1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[1], bias[1])), invArea);
+                    __m128 w2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[2], bias[2])), invArea);
+                    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, z0), _mm_mul_ps(w1, z1)), _mm_mul_ps(w2, z2));
+                    samples += writeQuadDepth(depthBuffer, width, height, z, mask, x, y, func, write);
+                }
+                else
+                {
+                    bool done = false;
+                    for (int i = 0; i < 3; ++i)
+                        done = done || ((decreasing & (1 << i)) && _mm_movemask_ps(_mm_castsi128_ps(edge[i])) == 0xF);
+                    if (done)
+                        break;
+                }
+                for (int i = 0; i < 3; ++i)
+                    edge[i] = _mm_add_epi32(edge[i], quadStep[i]);
+            }
+            continue;
+        }
 
-            //  
-            for (int x = xStart; x < xBlockStart; ++x)
+        //  :   int64,  int32    
+        for (int x = xStart; x <= iMaxX; x += 2)
+        {
+            int64_t lane[3][4];
+            __m128i edgeLanes[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                int64_t a = setup.Edge[i].A, b = setup.Edge[i].B;
+                lane[i][0] = e[i];
+                lane[i][1] = e[i] + a;
+                lane[i][2] = e[i] + b;
+                lane[i][3] = e[i] + a + b;
+                edgeLanes[i] = _mm_setr_epi32(clampEdge(lane[i][0], INT32_MAX), clampEdge(lane[i][1], INT32_MAX),
+                                              clampEdge(lane[i][2], INT32_MAX), clampEdge(lane[i][3], INT32_MAX));
+                e[i] += a * 2;
+            }
+            __m128i lanes = _mm_or_si128(_mm_or_si128(edgeLanes[0], edgeLanes[1]), edgeLanes[2]);
+            int mask = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+            if (mask)
             {
-                float2 p((float)x + 0.5f, (float)y + 0.5f);
-                float f0 = edgeFunction(v1.Position, v2.Position, p);
-                float f1 = edgeFunction(v2.Position, v0.Position, p);
-                float f2 = edgeFunction(v0.Position, v1.Position, p);
-                if ((area2 > 0 && (f0 < 0 || f1 < 0 || f2 < 0)) || (area2 < 0 && (f0 > 0 || f1 > 0 || f2 > 0)))
-                    continue;
-
-                float a = f0 / area2;
-                float b = f1 / area2;
-                float c = f2 / area2;
-                float z = a * v0.Position.z + b * v1.Position.z + c * v2.Position.z;
-                float4 color = a * v0.Color + b * v1.Color + c * v2.Color;
-                float2 uv = a * v0.UV + b * v1.UV + c * v2.UV;
-
-                int idx = y * width + x;
-                if (z < m_depthBuffer.at(idx))
+                __m128 w[3];
+                for (int i = 0; i < 3; ++i)
                 {
-                    m_depthBuffer.at(idx) = z;
-                    VertexOutput frag;
-                    frag.Position = float4((float)x, (float)y, z, 1.0f);
-                    frag.Color = color;
-                    frag.UV = uv;
-                    float4 finalColor = ps(frag, cb);
-                    rt->set_pixel(int2(x, y), finalColor);
+                    int64_t b = setup.Edge[i].Bias;
+                    w[i] = _mm_mul_ps(_mm_setr_ps((float)(lane[i][0] - b), (float)(lane[i][1] - b),
+                                                  (float)(lane[i][2] - b), (float)(lane[i][3] - b)),
+                                      invArea);
                 }
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], z0), _mm_mul_ps(w[1], z1)), _mm_mul_ps(w[2], z2));
+                samples += writeQuadDepth(depthBuffer, width, height, z, mask, x, y, func, write);
             }
+            else
+            {
+                bool done = false;
+                for (int i = 0; i < 3; ++i)
+                    done = done || ((decreasing & (1 << i)) && _mm_movemask_ps(_mm_castsi128_ps(edgeLanes[i])) == 0xF);
+                if (done)
+                    break;
+            }
+        }
+    }
+    return samples;
+}
+
+uint64_t Device::RasterizeTriangleTileMSAA(const int3& tri, int2 tileMin, int2 tileMax)
+{
+    IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
+    if (!rt) return 0;
+
+    const float4& p0 = m_transformedVerts.Positions[tri.x];
+    const float4& p1 = m_transformedVerts.Positions[tri.y];
+    const float4& p2 = m_transformedVerts.Positions[tri.z];
 
-            // SSE-
-            for (int x = xBlockStart; x < xBlockEnd; x += 4)
+    // ,         ,  
+    TriangleSetup setup;
+    if (!setupTriangle(p0, p1, p2, m_DeviceContext.GetCullMode(), setup, MSAA_SAMPLE_REACH))
+        return 0;
+
+    int iMinX = std::max(setup.MinX, tileMin.x);
+    int iMaxX = std::min(setup.MaxX, tileMax.x);
+    int iMinY = std::max(setup.MinY, tileMin.y);
+    int iMaxY = std::min(setup.MaxY, tileMax.y);
+    if (iMinX > iMaxX || iMinY > iMaxY)
+        return 0;
+
+    TrianglePlanes planes;
+    loadTrianglePlanes(planes, m_transformedVerts, tri, m_varyingCount);
+    PixelTarget target = {m_sampleDepth.data(), rt->width(), rt->height(), &m_pixelProgram,
+                          m_DeviceContext.GetConstantBuffer(), m_DeviceContext.GetSamplers(), m_depthFunc, m_depthWrite};
+    PixelQuadOutput color;
+    uint64_t samples = 0;
+
+    //     -        :
+    // A  B  256,   -   
+    int64_t sampleOffset[3][MSAA_SAMPLE_COUNT];
+    __m128i laneStep[3], quadStep[3], bias[3], sampleStep[3][MSAA_SAMPLE_COUNT];
+    bool narrow = true;
+    float dzdx = 0.0f, dzdy = 0.0f;
+    const float z[3] = {p0.z, p1.z, p2.z};
+    for (int i = 0; i < 3; ++i)
+    {
+        const EdgeEquation& edge = setup.Edge[i];
+        narrow = narrow && std::abs(edge.A) < EDGE_NARROW_STEP && std::abs(edge.B) < EDGE_NARROW_STEP;
+        int32_t a = narrow ? (int32_t)edge.A : 0;
+        int32_t b = narrow ? (int32_t)edge.B : 0;
+        laneStep[i] = _mm_setr_epi32(0, a, b, a + b);
+        quadStep[i] = _mm_set1_epi32(a * 2);
+        bias[i] = _mm_set1_epi32((int32_t)edge.Bias);
+        for (uint32_t s = 0; s < MSAA_SAMPLE_COUNT; ++s)
+        {
+            sampleOffset[i][s] = (edge.A * MSAA_SAMPLE_X16[s] + edge.B * MSAA_SAMPLE_Y16[s]) / 16;
+            sampleStep[i][s] = _mm_set1_epi32(narrow ? (int32_t)sampleOffset[i][s] : 0);
+        }
+        //   i   A / Area    x   B / Area  y
+        dzdx += (float)edge.A * setup.InvArea * z[i];
+        dzdy += (float)edge.B * setup.InvArea * z[i];
+    }
+    alignas(16) float sampleDepthOffset[MSAA_SAMPLE_COUNT];
+    for (uint32_t s = 0; s < MSAA_SAMPLE_COUNT; ++s)
+        sampleDepthOffset[s] = (dzdx * MSAA_SAMPLE_X16[s] + dzdy * MSAA_SAMPLE_Y16[s]) * (1.0f / 16.0f);
+    __m128 zOffset = _mm_load_ps(sampleDepthOffset);
+    __m128 invArea = _mm_set1_ps(setup.InvArea);
+
+    int xFirst = iMinX & ~1, yFirst = iMinY & ~1;
+    int quads = (iMaxX - xFirst) / 2 + 1;
+    for (int y = yFirst; y <= iMaxY; y += 2)
+    {
+        int64_t e[3];
+        bool exact = narrow;
+        for (int i = 0; i < 3; ++i)
+        {
+            const EdgeEquation& edge = setup.Edge[i];
+            e[i] = edge.Evaluate(xFirst, y);
+            //     -        
+            exact = exact && std::abs(e[i]) + std::abs(edge.A) * (quads * 2 + 1) + std::abs(edge.B) * 2 <
+                                 EDGE_NARROW_LIMIT;
+        }
+
+        __m128i edge[3];
+        for (int i = 0; i < 3; ++i)
+            edge[i] = _mm_add_epi32(_mm_set1_epi32(exact ? (int32_t)e[i] : 0), laneStep[i]);
+
+        for (int x = xFirst; x <= iMaxX; x += 2)
+        {
+            int mask = quadMask(x, y, iMinX, iMaxX, iMinY, iMaxY);
+            int coverage = 0;
+            __m128 w[3];
+            if (exact)
             {
-                __m128 baseX = _mm_set_ps(x + 3.5f, x + 2.5f, x + 1.5f, x + 0.5f);
+                for (uint32_t s = 0; s < MSAA_SAMPLE_COUNT; ++s)
+                {
+                    __m128i lanes = _mm_or_si128(_mm_or_si128(_mm_add_epi32(edge[0], sampleStep[0][s]),
+                                                              _mm_add_epi32(edge[1], sampleStep[1][s])),
+                                                 _mm_add_epi32(edge[2], sampleStep[2][s]));
+                    int covered = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & mask;
+                    coverage |= SAMPLE_COVERAGE_SPREAD[covered] << s;
+                }
+                if (coverage)
+                {
+                    for (int i = 0; i < 3; ++i)
+                        w[i] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[i], bias[i])), invArea);
+                }
+                for (int i = 0; i < 3; ++i)
+                    edge[i] = _mm_add_epi32(edge[i], quadStep[i]);
+            }
+            else
+            {
+                //  :   int64,      int32
+                int64_t lane[3][4];
+                for (int i = 0; i < 3; ++i)
+                {
+                    int64_t a = setup.Edge[i].A, b = setup.Edge[i].B;
+                    lane[i][0] = e[i];
+                    lane[i][1] = e[i] + a;
+                    lane[i][2] = e[i] + b;
+                    lane[i][3] = e[i] + a + b;
+                    e[i] += a * 2;
+                }
+                for (uint32_t s = 0; s < MSAA_SAMPLE_COUNT; ++s)
+                {
+                    __m128i lanes = _mm_setzero_si128();
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        int64_t o = sampleOffset[i][s];
+                        lanes = _mm_or_si128(lanes, _mm_setr_epi32(clampEdge(lane[i][0] + o, INT32_MAX),
+                                                                   clampEdge(lane[i][1] + o, INT32_MAX),
+                                                                   clampEdge(lane[i][2] + o, INT32_MAX),
+                                                                   clampEdge(lane[i][3] + o, INT32_MAX)));
+                    }
+                    int covered = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) & mask;
+                    coverage |= SAMPLE_COVERAGE_SPREAD[covered] << s;
+                }
+                for (int i = 0; i < 3; ++i)
+                {
+                    int64_t b = setup.Edge[i].Bias;
+                    w[i] = _mm_mul_ps(_mm_setr_ps((float)(lane[i][0] - b), (float)(lane[i][1] - b),
+                                                  (float)(lane[i][2] - b), (float)(lane[i][3] - b)),
+                                      invArea);
+                }
+            }
+            if (coverage == 0)
+                continue;
+            if (int written = shadeQuadMultisample(target, planes, w, coverage, x, y, zOffset, color))
+            {
+                writeQuadSamples(color, written, x, y);
+                samples += _mm_popcnt_u32(written);
+            }
+        }
+    }
+    return samples;
+}
 
-                __m128 f01 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v0x), dy01v), _mm_mul_ps(_mm_sub_ps(baseY, v0y), dx01v));
-                __m128 f12 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v1x), dy12v), _mm_mul_ps(_mm_sub_ps(baseY, v1y), dx12v));
-                __m128 f20 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(baseX, v2x), dy20v), _mm_mul_ps(_mm_sub_ps(baseY, v2y), dx20v));
+uint64_t Device::RasterizeSmallTrianglesSSE(const int* triIndices, int count, int2 tileMin, int2 tileMax)
+{
+    IRenderTarget* rt = m_DeviceContext.GetRenderTarget();
+    if (!rt) return 0;
+    int width = rt->width();
 
-                __m128 zero = _mm_setzero_ps();
-                __m128 inside;
-                if (area2 > 0)
-                    inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(f01, zero), _mm_cmpge_ps(f12, zero)), _mm_cmpge_ps(f20, zero));
-                else
-                    inside = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(f01, zero), _mm_cmple_ps(f12, zero)), _mm_cmple_ps(f20, zero));
-
-                int insideMask = _mm_movemask_ps(inside);
-                if (insideMask == 0) continue;
-
-                __m128 alpha = _mm_mul_ps(f12, invArea);
-                __m128 beta  = _mm_mul_ps(f20, invArea);
-                __m128 gamma = _mm_mul_ps(f01, invArea);
-
-                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0z), _mm_mul_ps(beta, v1z)), _mm_mul_ps(gamma, v2z));
-                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cr), _mm_mul_ps(beta, v1cr)), _mm_mul_ps(gamma, v2cr));
-                __m128 g = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cg), _mm_mul_ps(beta, v1cg)), _mm_mul_ps(gamma, v2cg));
-                __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0cb), _mm_mul_ps(beta, v1cb)), _mm_mul_ps(gamma, v2cb));
-                __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0ca), _mm_mul_ps(beta, v1ca)), _mm_mul_ps(gamma, v2ca));
-                __m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0u), _mm_mul_ps(beta, v1u)), _mm_mul_ps(gamma, v2u));
-                __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, v0v), _mm_mul_ps(beta, v1v)), _mm_mul_ps(gamma, v2v));
-
-                int idx0 = y * width + x;
-                __m128 depths = _mm_loadu_ps(&m_depthBuffer.at(idx0));
-                __m128 depthCmp = _mm_cmplt_ps(z, depths);
-                int depthMask = _mm_movemask_ps(depthCmp) & insideMask;
-                if (depthMask == 0) continue;
-
-                float zArr[4], rArr[4], gArr[4], bArr[4], aArr[4], uArr[4], vArr[4];
-                _mm_storeu_ps(zArr, z);
-                _mm_storeu_ps(rArr, r);
-                _mm_storeu_ps(gArr, g);
-                _mm_storeu_ps(bArr, b);
-                _mm_storeu_ps(aArr, a);
-                _mm_storeu_ps(uArr, u);
-                _mm_storeu_ps(vArr, v);
+    CullMode cull = m_DeviceContext.GetCullMode();
+    const float4* positions = m_transformedVerts.Positions.data();
+    PixelTarget target = {m_depthTarget->data(), width, rt->height(), &m_pixelProgram,
+                          m_DeviceContext.GetConstantBuffer(), m_DeviceContext.GetSamplers(), m_depthFunc, m_depthWrite};
+    PixelQuadOutput color;
+    TrianglePlanes planes;
+    uint64_t samples = 0;
 
-                for (int i = 0; i < 4; ++i)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int first = 0; first < count; first += 4)
+    {
+        int batch = std::min(4, count - first);
+
+        //        bbox   
+        alignas(16) float px[3][4], py[3][4];
+        for (int t = 0; t < 4; ++t)
+        {
+            const int3& tri = m_triangles[triIndices[first + std::min(t, batch - 1)]];
+            const int index[3] = {tri.x, tri.y, tri.z};
+            for (int v = 0; v < 3; ++v)
+            {
+                px[v][t] = positions[index[v]].x;
+                py[v][t] = positions[index[v]].y;
+            }
+        }
+        __m128i X[3], Y[3];
+        for (int v = 0; v < 3; ++v)
+        {
+            X[v] = snapSubpixel4(_mm_load_ps(px[v]));
+            Y[v] = snapSubpixel4(_mm_load_ps(py[v]));
+        }
+        __m128i pixelBias = _mm_set1_epi32((1 << SUBPIXEL_BITS) - 1 - SUBPIXEL_HALF);
+        __m128i pixelHalf = _mm_set1_epi32(SUBPIXEL_HALF);
+        __m128i minX = _mm_min_epi32(X[0], _mm_min_epi32(X[1], X[2]));
+        __m128i maxX = _mm_max_epi32(X[0], _mm_max_epi32(X[1], X[2]));
+        __m128i minY = _mm_min_epi32(Y[0], _mm_min_epi32(Y[1], Y[2]));
+        __m128i maxY = _mm_max_epi32(Y[0], _mm_max_epi32(Y[1], Y[2]));
+        __m128i bbMinX = _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(minX, pixelBias), SUBPIXEL_BITS), _mm_set1_epi32(tileMin.x));
+        __m128i bbMaxX = _mm_min_epi32(_mm_srai_epi32(_mm_sub_epi32(maxX, pixelHalf), SUBPIXEL_BITS), _mm_set1_epi32(tileMax.x));
+        __m128i bbMinY = _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(minY, pixelBias), SUBPIXEL_BITS), _mm_set1_epi32(tileMin.y));
+        __m128i bbMaxY = _mm_min_epi32(_mm_srai_epi32(_mm_sub_epi32(maxY, pixelHalf), SUBPIXEL_BITS), _mm_set1_epi32(tileMax.y));
+        __m128i empty = _mm_or_si128(_mm_cmpgt_epi32(bbMinX, bbMaxX), _mm_cmpgt_epi32(bbMinY, bbMaxY));
+
+        //    ,    2x2
+        __m128i originX = _mm_and_si128(bbMinX, _mm_set1_epi32(~1));
+        __m128i originY = _mm_and_si128(bbMinY, _mm_set1_epi32(~1));
+        __m128i X0 = _mm_sub_epi32(X[0], _mm_slli_epi32(originX, SUBPIXEL_BITS));
+        __m128i X1 = _mm_sub_epi32(X[1], _mm_slli_epi32(originX, SUBPIXEL_BITS));
+        __m128i X2 = _mm_sub_epi32(X[2], _mm_slli_epi32(originX, SUBPIXEL_BITS));
+        __m128i Y0 = _mm_sub_epi32(Y[0], _mm_slli_epi32(originY, SUBPIXEL_BITS));
+        __m128i Y1 = _mm_sub_epi32(Y[1], _mm_slli_epi32(originY, SUBPIXEL_BITS));
+        __m128i Y2 = _mm_sub_epi32(Y[2], _mm_slli_epi32(originY, SUBPIXEL_BITS));
+
+        //    8x8,    16   :     int32
+        __m128i blockLimit = _mm_set1_epi32(SMALL_TRIANGLE_BLOCK);
+        __m128i fitsMask = _mm_and_si128(_mm_cmplt_epi32(_mm_sub_epi32(bbMaxX, originX), blockLimit),
+                                         _mm_cmplt_epi32(_mm_sub_epi32(bbMaxY, originY), blockLimit));
+        __m128i reach = _mm_set1_epi32(16 << SUBPIXEL_BITS);
+        __m128i farthest = _mm_max_epi32(_mm_max_epi32(_mm_max_epi32(_mm_abs_epi32(X0), _mm_abs_epi32(X1)), _mm_abs_epi32(X2)),
+                                         _mm_max_epi32(_mm_max_epi32(_mm_abs_epi32(Y0), _mm_abs_epi32(Y1)), _mm_abs_epi32(Y2)));
+        fitsMask = _mm_and_si128(fitsMask, _mm_cmplt_epi32(farthest, reach));
+        //   ,    
+        X0 = _mm_and_si128(X0, fitsMask), X1 = _mm_and_si128(X1, fitsMask), X2 = _mm_and_si128(X2, fitsMask);
+        Y0 = _mm_and_si128(Y0, fitsMask), Y1 = _mm_and_si128(Y1, fitsMask), Y2 = _mm_and_si128(Y2, fitsMask);
+
+        alignas(16) int32_t blockX[4], blockY[4], bbox[4][4];
+        _mm_store_si128((__m128i*)blockX, originX);
+        _mm_store_si128((__m128i*)blockY, originY);
+        _mm_store_si128((__m128i*)bbox[0], bbMinX);
+        _mm_store_si128((__m128i*)bbox[1], bbMaxX);
+        _mm_store_si128((__m128i*)bbox[2], bbMinY);
+        _mm_store_si128((__m128i*)bbox[3], bbMaxY);
+        int batchMask = (1 << batch) - 1;
+        int emptyBits = _mm_movemask_ps(_mm_castsi128_ps(empty));
+        int fits = _mm_movemask_ps(_mm_castsi128_ps(fitsMask)) & ~emptyBits & batchMask;
+
+        //      (SoA, int32): E = A * x + B * y + C
+        //    , x  y -   
+        __m128i area = _mm_sub_epi32(_mm_mullo_epi32(_mm_sub_epi32(X2, X0), _mm_sub_epi32(Y1, Y0)),
+                                     _mm_mullo_epi32(_mm_sub_epi32(Y2, Y0), _mm_sub_epi32(X1, X0)));
+        //    area > 0:      
+        __m128i flip = _mm_cmplt_epi32(area, zero);
+        area = _mm_abs_epi32(area);
+
+        alignas(16) int32_t edgeA[3][4], edgeB[3][4], edgeC[3][4], edgeBias[3][4];
+        const __m128i* from[3][2] = {{&X1, &Y1}, {&X2, &Y2}, {&X0, &Y0}};
+        const __m128i* to[3][2] = {{&X2, &Y2}, {&X0, &Y0}, {&X1, &Y1}};
+        __m128i half = _mm_set1_epi32(SUBPIXEL_HALF);
+        for (int i = 0; i < 3; ++i)
+        {
+            __m128i xa = *from[i][0], ya = *from[i][1];
+            __m128i dx = _mm_sub_epi32(*to[i][0], xa), dy = _mm_sub_epi32(*to[i][1], ya);
+            __m128i a = _mm_slli_epi32(dy, SUBPIXEL_BITS);
+            __m128i b = _mm_sub_epi32(zero, _mm_slli_epi32(dx, SUBPIXEL_BITS));
+            __m128i c = _mm_sub_epi32(_mm_mullo_epi32(_mm_sub_epi32(half, xa), dy), _mm_mullo_epi32(_mm_sub_epi32(half, ya), dx));
+            a = _mm_sub_epi32(_mm_xor_si128(a, flip), flip);
+            b = _mm_sub_epi32(_mm_xor_si128(b, flip), flip);
+            c = _mm_sub_epi32(_mm_xor_si128(c, flip), flip);
+            // top-left: A > 0  (A == 0  B > 0);     ( -1)
+            __m128i topLeft = _mm_or_si128(_mm_cmpgt_epi32(a, zero), _mm_and_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpgt_epi32(b, zero)));
+            __m128i bias = _mm_andnot_si128(topLeft, _mm_set1_epi32(-1));
+            _mm_store_si128((__m128i*)edgeA[i], a);
+            _mm_store_si128((__m128i*)edgeB[i], b);
+            _mm_store_si128((__m128i*)edgeC[i], _mm_add_epi32(c, bias));
+            _mm_store_si128((__m128i*)edgeBias[i], bias);
+        }
+        //         
+        int live = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(area, zero)));
+        int flipBits = _mm_movemask_ps(_mm_castsi128_ps(flip));
+        if (cull == CullMode::Back) live &= ~flipBits;
+        if (cull == CullMode::Front) live &= flipBits;
+        alignas(16) int32_t areaArr[4];
+        _mm_store_si128((__m128i*)areaArr, area);
+
+        for (int t = 0; t < batch; ++t)
+        {
+            if (emptyBits & (1 << t))
+                continue;
+            const int3& tri = m_triangles[triIndices[first + t]];
+            if (!(fits & (1 << t)))
+            {
+                samples += RasterizeTriangleTileSSE(tri, tileMin, tileMax);
+                continue;
+            }
+            if (!(live & (1 << t)))
+                continue;
+
+            int iMinX = bbox[0][t], iMaxX = bbox[1][t], iMinY = bbox[2][t], iMaxY = bbox[3][t];
+
+            //      :  4x4 
+            constexpr int BLOCK_QUADS = SMALL_TRIANGLE_BLOCK / 2;
+            int quadsX = (iMaxX - blockX[t]) / 2 + 1;
+            int quadsY = (iMaxY - blockY[t]) / 2 + 1;
+            __m128i lane[3], stepX[3], stepY[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                int32_t a = edgeA[i][t], b = edgeB[i][t], c = edgeC[i][t];
+                lane[i] = _mm_setr_epi32(c, c + a, c + b, c + a + b);
+                stepX[i] = _mm_set1_epi32(a * 2);
+                stepY[i] = _mm_set1_epi32(b * 2);
+            }
+
+            __m128i edge[BLOCK_QUADS][BLOCK_QUADS][3];
+            int coverage[BLOCK_QUADS][BLOCK_QUADS];
+            int anyCovered = 0;
+            for (int qy = 0; qy < quadsY; ++qy)
+            {
+                __m128i row[3];
+                for (int i = 0; i < 3; ++i)
+                    row[i] = lane[i];
+                for (int qx = 0; qx < quadsX; ++qx)
                 {
-                    if (depthMask & (1 << i))
+                    __m128i lanes = zero;
+                    for (int i = 0; i < 3; ++i)
                     {
-                        int px = x + i;
-                        int py = y;
-                        int idx = py * width + px;
-                        m_depthBuffer.at(idx) = zArr[i];
-
-                        VertexOutput frag;
-                        frag.Position = float4((float)px, (float)py, zArr[i], 1.0f);
-                        frag.Color = float4(rArr[i], gArr[i], bArr[i], aArr[i]);
-                        frag.UV = float2(uArr[i], vArr[i]);
-
-                        float4 finalColor = ps(frag, cb);
-                        rt->set_pixel(int2(px, py), finalColor);
+                        edge[qy][qx][i] = row[i];
+                        lanes = _mm_or_si128(lanes, row[i]);
+                        row[i] = _mm_add_epi32(row[i], stepX[i]);
                     }
+                    coverage[qy][qx] = ~_mm_movemask_ps(_mm_castsi128_ps(lanes)) &
+                                       quadMask(blockX[t] + qx * 2, blockY[t] + qy * 2, iMinX, iMaxX, iMinY, iMaxY);
+                    anyCovered |= coverage[qy][qx];
                 }
+                for (int i = 0; i < 3; ++i)
+                    lane[i] = _mm_add_epi32(lane[i], stepY[i]);
             }
+            if (anyCovered == 0)
+                continue;
 
-            //  
-            for (int x = xBlockEnd; x <= xEnd; ++x)
+            loadTrianglePlanes(planes, m_transformedVerts, tri, m_varyingCount);
+            __m128 invArea = _mm_set1_ps(1.0f / (float)areaArr[t]);
+            for (int qy = 0; qy < quadsY; ++qy)
             {
-                float2 p((float)x + 0.5f, (float)y + 0.5f);
-                float f0 = edgeFunction(v1.Position, v2.Position, p);
-                float f1 = edgeFunction(v2.Position, v0.Position, p);
-                float f2 = edgeFunction(v0.Position, v1.Position, p);
-                if ((area2 > 0 && (f0 < 0 || f1 < 0 || f2 < 0)) || (area2 < 0 && (f0 > 0 || f1 > 0 || f2 > 0)))
-                    continue;
-
-                float a = f0 / area2;
-                float b = f1 / area2;
-                float c = f2 / area2;
-                float z = a * v0.Position.z + b * v1.Position.z + c * v2.Position.z;
-                float4 color = a * v0.Color + b * v1.Color + c * v2.Color;
-                float2 uv = a * v0.UV + b * v1.UV + c * v2.UV;
-
-                int idx = y * width + x;
-                if (z < m_depthBuffer.at(idx))
+                for (int qx = 0; qx < quadsX; ++qx)
                 {
-                    m_depthBuffer.at(idx) = z;
-                    VertexOutput frag;
-                    frag.Position = float4((float)x, (float)y, z, 1.0f);
-                    frag.Color = color;
-                    frag.UV = uv;
-                    float4 finalColor = ps(frag, cb);
-                    rt->set_pixel(int2(x, y), finalColor);
+                    if (coverage[qy][qx] == 0)
+                        continue;
+                    __m128 w[3];
+                    for (int i = 0; i < 3; ++i)
+                        w[i] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(edge[qy][qx][i], _mm_set1_epi32(edgeBias[i][t]))), invArea);
+                    int qx0 = blockX[t] + qx * 2, qy0 = blockY[t] + qy * 2;
+                    if (int written = shadeQuad(target, planes, w, coverage[qy][qx], qx0, qy0, color))
+                    {
+                        writeQuad(color, written, qx0, qy0);
+                        samples += _mm_popcnt_u32(written);
+                    }
                 }
             }
         }
     }
+    return samples;
 }
 
 void Device::renderTile(int tileIndex)
@@ -422,11 +1241,48 @@ void Device::renderTile(int tileIndex)
     }
 #endif
 
-    for (int triIdx : tile.triangleIndices)
+    const std::vector<int>& triangles = tile.triangleIndices;
+    size_t count = triangles.size();
+    uint64_t samples = 0;
+    if (m_depthOnly)
     {
-        const auto& tri = m_triangles[triIdx];
-        RasterizeTriangleTileSSE(m_transformedVerts[tri.x], m_transformedVerts[tri.y], m_transformedVerts[tri.z], tile.min, tile.max);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const int3& tri = m_triangles[triangles[i]];
+            int2 rectMin = tile.min, rectMax = tile.max;
+            if (m_clipTriangles)
+                clipToViewport(triangleViewport(tri), rectMin, rectMax);
+            samples += RasterizeTriangleTileDepth(tri, rectMin, rectMax);
+        }
+        m_tileSamples[tileIndex].Passed = samples;
+        return;
+    }
+
+    //       ,  .
+    //          
+    size_t i = 0;
+    while (i < count)
+    {
+        const int3& tri = m_triangles[triangles[i]];
+        uint32_t viewport = m_clipTriangles ? triangleViewport(tri) : 0;
+        int2 rectMin = tile.min, rectMax = tile.max;
+        if (m_clipTriangles)
+            clipToViewport(viewport, rectMin, rectMax);
+
+        size_t run = i;
+        while (run < count && m_smallTriangles[triangles[run]] &&
+               (!m_clipTriangles || triangleViewport(m_triangles[triangles[run]]) == viewport))
+            ++run;
+        if (run > i)
+        {
+            samples += RasterizeSmallTrianglesSSE(triangles.data() + i, (int)(run - i), rectMin, rectMax);
+            i = run;
+            continue;
+        }
+        samples += RasterizeTriangleTileSSE(tri, rectMin, rectMax);
+        ++i;
     }
+    m_tileSamples[tileIndex].Passed = samples;
 }
 
 SOFTX_END
@@ -0,0 +1,541 @@
+#include "pch.h"
+#include <SoftX/SoftX.h>
+#include <algorithm>
+#include <cfloat>
+
+SOFTX_BEGIN
+
+namespace
+{
+// ==========   ==========
+
+//     ,    
+const uint32_t* sourceIndices(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                              std::vector<uint32_t>& copy)
+{
+    if (destination != indices)
+        return indices;
+    copy.assign(indices, indices + indexCount);
+    return copy.data();
+}
+
+// FIFO-   :   ,      cacheSize  .
+//     .
+uint32_t updateCache(uint32_t a, uint32_t b, uint32_t c, uint32_t cacheSize, std::vector<uint32_t>& timestamps,
+                     uint32_t& timestamp)
+{
+    uint32_t misses = 0;
+    const uint32_t tri[3] = {a, b, c};
+    for (uint32_t v : tri)
+    {
+        if (timestamp - timestamps[v] > cacheSize)
+        {
+            timestamps[v] = timestamp++;
+            ++misses;
+        }
+    }
+    return misses;
+}
+
+// ==========    ==========
+
+const uint32_t kCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastTriScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+float vertexScore(int cachePosition, uint32_t remainingValence)
+{
+    //         
+    if (remainingValence == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        //      ,
+        //        
+        if (cachePosition < 3)
+            score = kLastTriScore;
+        else
+            score = powf(1.0f - float(cachePosition - 3) / float(kCacheSize - 3), kCacheDecayPower);
+    }
+    //           
+    score += kValenceBoostScale * powf(float(remainingValence), -kValenceBoostPower);
+    return score;
+}
+} // namespace
+
+// ==========    ==========
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    std::vector<uint32_t> copy;
+    indices = sourceIndices(destination, indices, indexCount, copy);
+    size_t triCount = indexCount / 3;
+    if (triCount == 0)
+        return;
+
+    //    -> ; valence -     
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (size_t i = 0; i < triCount * 3; ++i)
+        ++valence[indices[i]];
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + valence[v];
+
+    std::vector<uint32_t> adjacency(triCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vScore[v] = vertexScore(-1, valence[v]);
+
+    std::vector<float> tScore(triCount);
+    std::vector<bool> emitted(triCount, false);
+    size_t bestTri = 0;
+    for (size_t t = 0; t < triCount; ++t)
+    {
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+        if (tScore[t] > tScore[bestTri])
+            bestTri = t;
+    }
+
+    //   3   : ,   ,
+    //   
+    uint32_t cache[kCacheSize + 3];
+    uint32_t newCache[kCacheSize + 3];
+    size_t cacheCount = 0;
+    size_t nextCandidate = 0; //  ,       
+
+    for (size_t out = 0; out < triCount; ++out)
+    {
+        if (bestTri == SIZE_MAX)
+        {
+            while (emitted[nextCandidate])
+                ++nextCandidate;
+            bestTri = nextCandidate;
+        }
+
+        const uint32_t* tri = indices + bestTri * 3;
+        destination[out * 3 + 0] = tri[0];
+        destination[out * 3 + 1] = tri[1];
+        destination[out * 3 + 2] = tri[2];
+        emitted[bestTri] = true;
+
+        //       
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t v = tri[k];
+            uint32_t* list = adjacency.data() + offsets[v];
+            uint32_t count = valence[v];
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (list[i] == bestTri)
+                {
+                    list[i] = list[count - 1];
+                    break;
+                }
+            }
+            --valence[v];
+        }
+
+        //  :    ,  
+        size_t newCount = 0;
+        for (int k = 0; k < 3; ++k)
+            newCache[newCount++] = tri[k];
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache[newCount++] = v;
+        }
+
+        //   ;       -1
+        for (size_t i = 0; i < newCount; ++i)
+        {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < kCacheSize ? (int)i : -1;
+            vScore[v] = vertexScore(cachePosition[v], valence[v]);
+        }
+
+        //        
+        bestTri = SIZE_MAX;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < newCount; ++i)
+        {
+            uint32_t v = newCache[i];
+            const uint32_t* list = adjacency.data() + offsets[v];
+            for (uint32_t j = 0; j < valence[v]; ++j)
+            {
+                uint32_t t = list[j];
+                const uint32_t* ti = indices + (size_t)t * 3;
+                tScore[t] = vScore[ti[0]] + vScore[ti[1]] + vScore[ti[2]];
+                if (tScore[t] > bestScore)
+                {
+                    bestScore = tScore[t];
+                    bestTri = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, (size_t)kCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+}
+
+// ==========   ==========
+
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                      size_t vertexCount, size_t positionStride, float threshold)
+{
+    std::vector<uint32_t> copy;
+    indices = sourceIndices(destination, indices, indexCount, copy);
+    size_t triCount = indexCount / 3;
+    if (triCount == 0)
+        return;
+
+    const uint32_t cacheSize = 16;
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+
+    // Ƹ :     -     ,
+    //        
+    std::vector<size_t> hard;
+    for (size_t t = 0; t < triCount; ++t)
+    {
+        const uint32_t* tri = indices + t * 3;
+        if (updateCache(tri[0], tri[1], tri[2], cacheSize, timestamps, timestamp) == 3 || t == 0)
+            hard.push_back(t);
+    }
+    hard.push_back(triCount);
+
+    //  :  ,  ACMR       threshold * ACMR 
+    const size_t kMinClusterSize = 8;
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h)
+    {
+        size_t start = hard[h];
+        size_t end = hard[h + 1];
+
+        timestamp += cacheSize + 1; //  
+        uint32_t misses = 0;
+        for (size_t t = start; t < end; ++t)
+            misses += updateCache(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2], cacheSize, timestamps,
+                                  timestamp);
+        float limit = threshold * float(misses) / float(end - start);
+
+        timestamp += cacheSize + 1;
+        size_t clusterStart = start;
+        uint32_t clusterMisses = 0;
+        clusters.push_back(start);
+        for (size_t t = start; t < end; ++t)
+        {
+            clusterMisses += updateCache(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2], cacheSize,
+                                         timestamps, timestamp);
+            size_t size = t + 1 - clusterStart;
+            if (t + 1 < end && size >= kMinClusterSize && float(clusterMisses) / float(size) <= limit)
+            {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                timestamp += cacheSize + 1;
+            }
+        }
+    }
+    clusters.push_back(triCount);
+    size_t clusterCount = clusters.size() - 1;
+
+    //   (    )
+    std::vector<float3> centroids(clusterCount, float3(0, 0, 0));
+    std::vector<float3> normals(clusterCount, float3(0, 0, 0));
+    std::vector<float> areas(clusterCount, 0.0f);
+    float3 meshCentroid(0, 0, 0);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            float3 p0 = loadFloat3(positions, positionStride, indices[t * 3]);
+            float3 p1 = loadFloat3(positions, positionStride, indices[t * 3 + 1]);
+            float3 p2 = loadFloat3(positions, positionStride, indices[t * 3 + 2]);
+            //      (  D3D)    
+            float3 n = cross(p2 - p0, p1 - p0);
+            float area = sqrtf(dot(n, n));
+            float3 center((p0.x + p1.x + p2.x) / 3, (p0.y + p1.y + p2.y) / 3, (p0.z + p1.z + p2.z) / 3);
+
+            centroids[c] = centroids[c] + center * area;
+            normals[c] = normals[c] + n;
+            areas[c] += area;
+        }
+        meshCentroid = meshCentroid + centroids[c];
+        meshArea += areas[c];
+    }
+    if (meshArea > 0.0f)
+        meshCentroid = meshCentroid / meshArea;
+
+    //  :       .    
+    //   ,   
+    std::vector<float> keys(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        if (areas[c] <= 0.0f)
+            continue;
+        float3 center = centroids[c] / areas[c];
+        float3 n = normals[c];
+        float length = sqrtf(dot(n, n));
+        if (length > 0.0f)
+            keys[c] = dot(center - meshCentroid, n) / length;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        order[c] = (uint32_t)c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    size_t out = 0;
+    for (uint32_t c : order)
+    {
+        size_t first = clusters[c] * 3;
+        size_t last = clusters[c + 1] * 3;
+        std::copy(indices + first, indices + last, destination + out);
+        out += last - first;
+    }
+}
+
+// ==========    ==========
+
+size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    std::fill(remap, remap + vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t v = indices[i];
+        if (remap[v] == ~0u)
+            remap[v] = next++;
+    }
+    return next;
+}
+
+void RemapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap)
+{
+    for (size_t i = 0; i < indexCount; ++i)
+        destination[i] = remap[indices[i]];
+}
+
+void RemapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t stride,
+                       const uint32_t* remap)
+{
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+    const uint8_t* src = static_cast<const uint8_t*>(vertices);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] != ~0u)
+            std::memcpy(dst + (size_t)remap[v] * stride, src + v * stride, stride);
+    }
+}
+
+// ==========  ==========
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    uint32_t cacheSize)
+{
+    VertexCacheStats stats = {};
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t unique = 0;
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        stats.VerticesTransformed +=
+            updateCache(indices[i], indices[i + 1], indices[i + 2], cacheSize, timestamps, timestamp);
+        for (int k = 0; k < 3; ++k)
+        {
+            if (!used[indices[i + k]])
+            {
+                used[indices[i + k]] = true;
+                ++unique;
+            }
+        }
+    }
+
+    size_t triCount = indexCount / 3;
+    stats.ACMR = triCount ? float(stats.VerticesTransformed) / float(triCount) : 0.0f;
+    stats.ATVR = unique ? float(stats.VerticesTransformed) / float(unique) : 0.0f;
+    return stats;
+}
+
+OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                              size_t positionStride)
+{
+    OverdrawStats stats = {};
+    if (indexCount < 3 || vertexCount == 0)
+        return stats;
+
+    //     
+    float3 bmin = loadFloat3(positions, positionStride, 0);
+    float3 bmax = bmin;
+    for (uint32_t v = 1; v < vertexCount; ++v)
+    {
+        float3 p = loadFloat3(positions, positionStride, v);
+        bmin = min(bmin, p);
+        bmax = max(bmax, p);
+    }
+    float extent = std::max(bmax.x - bmin.x, std::max(bmax.y - bmin.y, bmax.z - bmin.z));
+    float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+    const int kGrid = 256;
+    std::vector<float> depth(kGrid * kGrid);
+
+    //     ;   -    (CullMode::Back)
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int dir = -1; dir <= 1; dir += 2)
+        {
+            std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+            for (size_t i = 0; i + 2 < indexCount; i += 3)
+            {
+                float3 p[3];
+                float s[3][3]; // (u, v, )  
+                for (int k = 0; k < 3; ++k)
+                {
+                    float3 q = loadFloat3(positions, positionStride, indices[i + k]);
+                    p[k] = q;
+                    float c[3] = {(q.x - bmin.x) * scale, (q.y - bmin.y) * scale, (q.z - bmin.z) * scale};
+                    s[k][0] = c[(axis + 1) % 3] * (kGrid - 1);
+                    s[k][1] = c[(axis + 2) % 3] * (kGrid - 1);
+                    s[k][2] = c[axis] * dir;
+                }
+
+                //      -    
+                float3 n = cross(p[2] - p[0], p[1] - p[0]);
+                float facing = -(axis == 0 ? n.x : axis == 1 ? n.y : n.z) * dir;
+                if (facing <= 0.0f)
+                    continue;
+
+                float area = (s[1][0] - s[0][0]) * (s[2][1] - s[0][1]) - (s[2][0] - s[0][0]) * (s[1][1] - s[0][1]);
+                if (area == 0.0f)
+                    continue;
+                float invArea = 1.0f / area;
+
+                int minX = std::max(0, (int)floorf(std::min(s[0][0], std::min(s[1][0], s[2][0]))));
+                int maxX = std::min(kGrid - 1, (int)ceilf(std::max(s[0][0], std::max(s[1][0], s[2][0]))));
+                int minY = std::max(0, (int)floorf(std::min(s[0][1], std::min(s[1][1], s[2][1]))));
+                int maxY = std::min(kGrid - 1, (int)ceilf(std::max(s[0][1], std::max(s[1][1], s[2][1]))));
+
+                for (int y = minY; y <= maxY; ++y)
+                {
+                    for (int x = minX; x <= maxX; ++x)
+                    {
+                        float px = x + 0.5f, py = y + 0.5f;
+                        float w0 = ((s[2][0] - s[1][0]) * (py - s[1][1]) - (s[2][1] - s[1][1]) * (px - s[1][0])) * invArea;
+                        float w1 = ((s[0][0] - s[2][0]) * (py - s[2][1]) - (s[0][1] - s[2][1]) * (px - s[2][0])) * invArea;
+                        float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                            continue;
+
+                        float z = w0 * s[0][2] + w1 * s[1][2] + w2 * s[2][2];
+                        float& d = depth[y * kGrid + x];
+                        if (z < d)
+                        {
+                            if (d == FLT_MAX)
+                                ++stats.PixelsCovered;
+                            d = z;
+                            ++stats.PixelsShaded;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    stats.Overdraw = stats.PixelsCovered ? float(stats.PixelsShaded) / float(stats.PixelsCovered) : 0.0f;
+    return stats;
+}
+
+VertexFetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t stride)
+{
+    VertexFetchStats stats = {};
+
+    //   FIFO-  64   64 
+    const uint32_t kLineSize = 64;
+    const uint32_t kLines = 64;
+    size_t lineCount = (vertexCount * stride + kLineSize - 1) / kLineSize;
+    std::vector<uint32_t> timestamps(lineCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t timestamp = kLines + 1;
+    size_t unique = 0;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t v = indices[i];
+        if (!used[v])
+        {
+            used[v] = true;
+            ++unique;
+        }
+        size_t first = (size_t)v * stride / kLineSize;
+        size_t last = ((size_t)v * stride + stride - 1) / kLineSize;
+        for (size_t line = first; line <= last; ++line)
+        {
+            if (timestamp - timestamps[line] > kLines)
+            {
+                timestamps[line] = timestamp++;
+                stats.BytesFetched += kLineSize;
+            }
+        }
+    }
+
+    stats.Overfetch = unique ? float(stats.BytesFetched) / float(unique * stride) : 0.0f;
+    return stats;
+}
+
+// ==========     SoftX ==========
+
+bool OptimizeMesh(VertexBuffer& vb, IndexBuffer& ib, const InputLayout& layout, float overdrawThreshold)
+{
+    int slot = layout.FindElement("POSITION");
+    if (slot < 0)
+        return false;
+    const InputElement& position = layout.GetElement(slot);
+    if (position.Format != VertexFormat::Float3 && position.Format != VertexFormat::Float4)
+        return false;
+
+    size_t indexCount = ib.Size();
+    if (indexCount % 3 != 0)
+        return false;
+    if (indexCount == 0)
+        return true;
+
+    size_t vertexCount = vb.Size();
+    uint32_t stride = vb.Stride();
+    std::vector<uint32_t> indices(ib.Data(), ib.Data() + indexCount);
+    const float* positions = reinterpret_cast<const float*>(vb.Data() + position.Offset);
+
+    OptimizeVertexCache(indices.data(), indices.data(), indexCount, vertexCount);
+    OptimizeOverdraw(indices.data(), indices.data(), indexCount, positions, vertexCount, stride, overdrawThreshold);
+
+    std::vector<uint32_t> remap(vertexCount);
+    size_t uniqueCount = OptimizeVertexFetchRemap(remap.data(), indices.data(), indexCount, vertexCount);
+    RemapIndexBuffer(indices.data(), indices.data(), indexCount, remap.data());
+
+    std::vector<uint8_t> vertices(uniqueCount * stride);
+    RemapVertexBuffer(vertices.data(), vb.Data(), vertexCount, stride, remap.data());
+
+    vb = VertexBuffer(vertices.data(), uniqueCount, stride);
+    ib = IndexBuffer(indices);
+    return true;
+}
+
+SOFTX_END
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include <SoftX/SoftX.h>
+#include <algorithm>
+
+SOFTX_BEGIN
+
+namespace
+{
+//     
+void computeMeshletBounds(Meshlet& meshlet, const MeshletMesh& mesh, const float* positions, size_t stride)
+{
+    const uint32_t* vertices = mesh.Vertices.data() + meshlet.VertexOffset;
+    const uint8_t* triangles = mesh.Triangles.data() + meshlet.TriangleOffset;
+
+    // :  AABB ,  -     
+    float3 bmin = loadFloat3(positions, stride, vertices[0]);
+    float3 bmax = bmin;
+    for (uint32_t i = 1; i < meshlet.VertexCount; ++i)
+    {
+        float3 p = loadFloat3(positions, stride, vertices[i]);
+        bmin = min(bmin, p);
+        bmax = max(bmax, p);
+    }
+    float3 center((bmin.x + bmax.x) * 0.5f, (bmin.y + bmax.y) * 0.5f, (bmin.z + bmax.z) * 0.5f);
+    float radius2 = 0.0f;
+    for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+    {
+        float3 d = loadFloat3(positions, stride, vertices[i]) - center;
+        radius2 = std::max(radius2, dot(d, d));
+    }
+    meshlet.Bounds.Center = center;
+    meshlet.Bounds.Radius = sqrtf(radius2);
+
+    // :  -  ,  -   .
+    //      (  D3D) cross(e2, e1)  
+    std::vector<float3> normals;
+    normals.reserve(meshlet.TriangleCount);
+    float3 axis(0, 0, 0);
+    for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+    {
+        float3 p0 = loadFloat3(positions, stride, vertices[triangles[t * 3 + 0]]);
+        float3 p1 = loadFloat3(positions, stride, vertices[triangles[t * 3 + 1]]);
+        float3 p2 = loadFloat3(positions, stride, vertices[triangles[t * 3 + 2]]);
+        float3 n = cross(p2 - p0, p1 - p0);
+        float length = sqrtf(dot(n, n));
+        if (length <= 0.0f)
+            continue;
+        n = n * (1.0f / length);
+        normals.push_back(n);
+        axis = axis + n;
+    }
+
+    meshlet.ConeAxis = float3(0, 0, 0);
+    meshlet.ConeCutoff = 1.0f;
+    float axisLength = sqrtf(dot(axis, axis));
+    if (normals.empty() || axisLength <= 0.0f)
+        return;
+    axis = axis * (1.0f / axisLength);
+
+    float minDot = 1.0f;
+    for (const float3& n : normals)
+        minDot = std::min(minDot, dot(axis, n));
+
+    meshlet.ConeAxis = axis;
+    //  90    -     
+    if (minDot <= 0.0f)
+        return;
+    meshlet.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+}
+} // namespace
+
+bool BuildMeshlets(MeshletMesh& mesh, const uint32_t* indices, size_t indexCount, const float* positions,
+                   size_t vertexCount, size_t positionStride, uint32_t maxVertices, uint32_t maxTriangles)
+{
+    mesh.Meshlets.clear();
+    mesh.Vertices.clear();
+    mesh.Triangles.clear();
+    if (maxVertices < 3 || maxVertices > MESHLET_MAX_VERTICES || maxTriangles == 0 ||
+        maxTriangles > MESHLET_MAX_TRIANGLES || indexCount % 3 != 0)
+        return false;
+    for (size_t i = 0; i < indexCount; ++i)
+        if (indices[i] >= vertexCount)
+            return false;
+
+    //       (0xFF -   )
+    std::vector<uint8_t> local(vertexCount, 0xFF);
+    Meshlet current = {};
+
+    auto finish = [&]() {
+        if (current.TriangleCount == 0)
+            return;
+        for (uint32_t i = 0; i < current.VertexCount; ++i)
+            local[mesh.Vertices[current.VertexOffset + i]] = 0xFF;
+        computeMeshletBounds(current, mesh, positions, positionStride);
+        mesh.Meshlets.push_back(current);
+
+        current = {};
+        current.VertexOffset = (uint32_t)mesh.Vertices.size();
+        current.TriangleOffset = (uint32_t)mesh.Triangles.size();
+    };
+
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        //      (    )
+        uint32_t extra = (local[a] == 0xFF) + (b != a && local[b] == 0xFF) + (c != a && c != b && local[c] == 0xFF);
+
+        if (current.VertexCount + extra > maxVertices || current.TriangleCount + 1 > maxTriangles)
+            finish();
+
+        for (uint32_t v : {a, b, c})
+        {
+            if (local[v] == 0xFF)
+            {
+                local[v] = (uint8_t)current.VertexCount++;
+                mesh.Vertices.push_back(v);
+            }
+            mesh.Triangles.push_back(local[v]);
+        }
+        ++current.TriangleCount;
+    }
+    finish();
+    return true;
+}
+
+bool BuildMeshlets(MeshletMesh& mesh, const VertexBuffer& vb, const IndexBuffer& ib, const InputLayout& layout,
+                   uint32_t maxVertices, uint32_t maxTriangles)
+{
+    int slot = layout.FindElement("POSITION");
+    if (slot < 0)
+        return false;
+    const InputElement& position = layout.GetElement(slot);
+    if (position.Format != VertexFormat::Float3 && position.Format != VertexFormat::Float4)
+        return false;
+    if (vb.IsEmpty() || ib.IsEmpty())
+        return false;
+
+    const float* positions = reinterpret_cast<const float*>(vb.Data() + position.Offset);
+    return BuildMeshlets(mesh, ib.Data(), ib.Size(), positions, vb.Size(), vb.Stride(), maxVertices, maxTriangles);
+}
+
+SOFTX_END
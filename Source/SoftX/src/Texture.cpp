@@ -0,0 +1,1064 @@
+#include "pch.h"
+#include <SoftX/SoftX.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+SOFTX_BEGIN
+
+namespace
+{
+//        
+constexpr int PARALLEL_MIP_ROWS = 32;
+
+// f(begin, end)   ,       
+template <class F> void parallelRows(ThreadPool* pool, int rows, const F& f)
+{
+    int numThreads = pool ? (int)pool->threadCount() : 1;
+    if (numThreads < 2 || rows < PARALLEL_MIP_ROWS)
+    {
+        f(0, rows);
+        return;
+    }
+
+    int chunk = (rows + numThreads * 4 - 1) / (numThreads * 4);
+    for (int begin = 0; begin < rows; begin += chunk)
+    {
+        int end = std::min(begin + chunk, rows);
+        pool->enqueue([&f, begin, end]() { f(begin, end); });
+    }
+    pool->wait();
+}
+
+//      ()
+double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k)
+    {
+        double q = x / (2.0 * k);
+        term *= q * q;
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+//      .   x    2x  2x + 1,
+//  -  2x - 2 .. 2x + 3   0.5, 1.5, 2.5   
+constexpr int KAISER_TAPS = 6;
+
+void kaiserWeights(float weights[KAISER_TAPS])
+{
+    const double alpha = 4.0;
+    const double halfWidth = KAISER_TAPS / 2;
+    const double pi = 3.14159265358979323846;
+
+    double w[KAISER_TAPS], total = 0.0;
+    for (int i = 0; i < KAISER_TAPS; ++i)
+    {
+        double d = i - (KAISER_TAPS - 1) * 0.5;
+        double t = d / halfWidth;
+        double window = besselI0(alpha * std::sqrt(1.0 - t * t)) / besselI0(alpha);
+        //   -  : sinc(d / 2)
+        double x = pi * d * 0.5;
+        w[i] = window * std::sin(x) / x;
+        total += w[i];
+    }
+    for (int i = 0; i < KAISER_TAPS; ++i)
+        weights[i] = (float)(w[i] / total);
+}
+//    .   : I0, I1 -     ,
+// T -  I1; Valid0/Valid1 -    (   Border)
+struct AxisTaps
+{
+    __m128i I0, I1;
+    __m128 T;
+    __m128i Valid0, Valid1;
+};
+
+// ,   [0, 1]  Wrap  Mirror (  -  )
+template <TextureAddressMode Address> __m128 foldCoordinate(__m128 u)
+{
+    if (Address == TextureAddressMode::Wrap)
+        return _mm_sub_ps(u, _mm_floor_ps(u));
+    if (Address == TextureAddressMode::Mirror)
+    {
+        //  2:   1 - |2 * frac(u / 2) - 1|
+        __m128 half = _mm_mul_ps(u, _mm_set1_ps(0.5f));
+        __m128 f = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(half, _mm_floor_ps(half)), _mm_set1_ps(2.0f)), _mm_set1_ps(1.0f));
+        __m128 absF = _mm_andnot_ps(_mm_set1_ps(-0.0f), f);
+        return _mm_sub_ps(_mm_set1_ps(1.0f), absF);
+    }
+    return u;
+}
+
+__m128i clampIndex(__m128i i, __m128i maxIndex)
+{
+    return _mm_min_epi32(_mm_max_epi32(i, _mm_setzero_si128()), maxIndex);
+}
+
+__m128i insideIndex(__m128i i, int size)
+{
+    return _mm_and_si128(_mm_cmpgt_epi32(i, _mm_set1_epi32(-1)), _mm_cmplt_epi32(i, _mm_set1_epi32(size)));
+}
+
+template <TextureAddressMode Address> AxisTaps addressLinear(__m128 u, int size)
+{
+    __m128 sizeF = _mm_set1_ps((float)size);
+    u = foldCoordinate<Address>(u);
+    // _mm_max_ps     NaN;   [-1, size]  
+    __m128 f = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(u, sizeF), _mm_set1_ps(0.5f)), _mm_set1_ps(-1.0f)), sizeF);
+    __m128 f0 = _mm_floor_ps(f);
+
+    AxisTaps taps;
+    taps.T = _mm_sub_ps(f, f0);
+    taps.I0 = _mm_cvttps_epi32(f0);
+    taps.I1 = _mm_add_epi32(taps.I0, _mm_set1_epi32(1));
+    taps.Valid0 = taps.Valid1 = _mm_set1_epi32(-1);
+    __m128i maxIndex = _mm_set1_epi32(size - 1);
+    if (Address == TextureAddressMode::Wrap)
+    {
+        // I0  [-1, size - 1], I1  [0, size]:    
+        __m128i w = _mm_set1_epi32(size);
+        taps.I0 = _mm_add_epi32(taps.I0, _mm_and_si128(_mm_cmplt_epi32(taps.I0, _mm_setzero_si128()), w));
+        taps.I1 = _mm_sub_epi32(taps.I1, _mm_and_si128(_mm_cmpgt_epi32(taps.I1, maxIndex), w));
+        return taps;
+    }
+    if (Address == TextureAddressMode::Border)
+    {
+        taps.Valid0 = insideIndex(taps.I0, size);
+        taps.Valid1 = insideIndex(taps.I1, size);
+    }
+    // Clamp;  Mirror         
+    taps.I0 = clampIndex(taps.I0, maxIndex);
+    taps.I1 = clampIndex(taps.I1, maxIndex);
+    return taps;
+}
+
+//   ; valid -   AxisTaps
+template <TextureAddressMode Address> __m128i addressPoint(__m128 u, int size, __m128i& valid)
+{
+    __m128 sizeF = _mm_set1_ps((float)size);
+    u = foldCoordinate<Address>(u);
+    __m128 f = _mm_min_ps(_mm_max_ps(_mm_mul_ps(u, sizeF), _mm_set1_ps(-1.0f)), sizeF);
+    __m128i i = _mm_cvttps_epi32(_mm_floor_ps(f));
+    valid = Address == TextureAddressMode::Border ? insideIndex(i, size) : _mm_set1_epi32(-1);
+    return clampIndex(i, _mm_set1_epi32(size - 1));
+}
+
+//    ( Border)   
+void applyBorder(__m128i valid, __m128 border, __m128 texels[4])
+{
+    __m128 inside = _mm_castsi128_ps(valid);
+    texels[0] = _mm_blendv_ps(_mm_shuffle_ps(border, border, _MM_SHUFFLE(0, 0, 0, 0)), texels[0], inside);
+    texels[1] = _mm_blendv_ps(_mm_shuffle_ps(border, border, _MM_SHUFFLE(1, 1, 1, 1)), texels[1], inside);
+    texels[2] = _mm_blendv_ps(_mm_shuffle_ps(border, border, _MM_SHUFFLE(2, 2, 2, 2)), texels[2], inside);
+    texels[3] = _mm_blendv_ps(_mm_shuffle_ps(border, border, _MM_SHUFFLE(3, 3, 3, 3)), texels[3], inside);
+}
+
+//    UV (SoA)   width x height. fetch(x, y, texels) 
+//     (   )   SoA.
+//     :      
+template <TextureAddressMode AddressU, TextureAddressMode AddressV, class Fetch>
+void bilinear4(int width, int height, __m128 u, __m128 v, const Fetch& fetch, __m128 border, __m128 rgba[4])
+{
+    AxisTaps tu = addressLinear<AddressU>(u, width);
+    AxisTaps tv = addressLinear<AddressV>(v, height);
+
+    //   ,    
+    __m128 corner[4][4];
+    fetch(tu.I0, tv.I0, corner[0]);
+    fetch(tu.I1, tv.I0, corner[1]);
+    fetch(tu.I0, tv.I1, corner[2]);
+    fetch(tu.I1, tv.I1, corner[3]);
+    if (AddressU == TextureAddressMode::Border || AddressV == TextureAddressMode::Border)
+    {
+        applyBorder(_mm_and_si128(tu.Valid0, tv.Valid0), border, corner[0]);
+        applyBorder(_mm_and_si128(tu.Valid1, tv.Valid0), border, corner[1]);
+        applyBorder(_mm_and_si128(tu.Valid0, tv.Valid1), border, corner[2]);
+        applyBorder(_mm_and_si128(tu.Valid1, tv.Valid1), border, corner[3]);
+    }
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        __m128 top = _mm_add_ps(corner[0][ch], _mm_mul_ps(_mm_sub_ps(corner[1][ch], corner[0][ch]), tu.T));
+        __m128 bottom = _mm_add_ps(corner[2][ch], _mm_mul_ps(_mm_sub_ps(corner[3][ch], corner[2][ch]), tu.T));
+        rgba[ch] = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), tv.T));
+    }
+}
+
+template <TextureAddressMode AddressU, TextureAddressMode AddressV, class Fetch>
+void point4(int width, int height, __m128 u, __m128 v, const Fetch& fetch, __m128 border, __m128 rgba[4])
+{
+    __m128i validX, validY;
+    __m128i x = addressPoint<AddressU>(u, width, validX);
+    __m128i y = addressPoint<AddressV>(v, height, validY);
+    fetch(x, y, rgba);
+    if (AddressU == TextureAddressMode::Border || AddressV == TextureAddressMode::Border)
+        applyBorder(_mm_and_si128(validX, validY), border, rgba);
+}
+
+//   :     ,  -  
+template <class Fetch>
+void bilinear4(TextureAddressMode address, int width, int height, __m128 u, __m128 v, const Fetch& fetch,
+               __m128 rgba[4])
+{
+    __m128 border = _mm_setzero_ps();
+    switch (address)
+    {
+    case TextureAddressMode::Wrap:
+        bilinear4<TextureAddressMode::Wrap, TextureAddressMode::Wrap>(width, height, u, v, fetch, border, rgba);
+        break;
+    case TextureAddressMode::Mirror:
+        bilinear4<TextureAddressMode::Mirror, TextureAddressMode::Mirror>(width, height, u, v, fetch, border, rgba);
+        break;
+    case TextureAddressMode::Border:
+        bilinear4<TextureAddressMode::Border, TextureAddressMode::Border>(width, height, u, v, fetch, border, rgba);
+        break;
+    default:
+        bilinear4<TextureAddressMode::Clamp, TextureAddressMode::Clamp>(width, height, u, v, fetch, border, rgba);
+        break;
+    }
+}
+
+//       SoA
+void gatherTexels(const __m128* pixels, __m128i index, __m128 texels[4])
+{
+    alignas(16) int32_t offset[4];
+    _mm_store_si128((__m128i*)offset, index);
+    __m128 t0 = pixels[offset[0]], t1 = pixels[offset[1]], t2 = pixels[offset[2]], t3 = pixels[offset[3]];
+    _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+    texels[0] = t0;
+    texels[1] = t1;
+    texels[2] = t2;
+    texels[3] = t3;
+}
+
+//     Tiled:   4x4 * 16 + Z-   ( texel_index)
+__m128i tiledIndex(__m128i x, __m128i y, __m128i blocksPerRow)
+{
+    __m128i block = _mm_add_epi32(_mm_mullo_epi32(_mm_srli_epi32(y, 2), blocksPerRow), _mm_srli_epi32(x, 2));
+    __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    __m128i morton = _mm_or_si128(_mm_or_si128(_mm_and_si128(x, one), _mm_slli_epi32(_mm_and_si128(y, one), 1)),
+                                  _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, two), 1),
+                                               _mm_slli_epi32(_mm_and_si128(y, two), 2)));
+    return _mm_add_epi32(_mm_slli_epi32(block, 4), morton);
+}
+
+// ----   ----
+
+constexpr float INV_255 = 1.0f / 255.0f;
+
+uint32_t loadU32(const uint8_t* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t loadU64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+//  half   16    float.  half  
+//  float (  DAZ  )
+__m128 halfToFloat4(__m128i h)
+{
+    __m128i expMant = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+    __m128i sign = _mm_slli_epi32(_mm_xor_si128(_mm_and_si128(h, _mm_set1_epi32(0xFFFF)), expMant), 16);
+    //    float     (15 -> 127)   2^112
+    __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)),
+                               _mm_castsi128_ps(_mm_set1_epi32((127 + 112) << 23)));
+    __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(0xFF << 23));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+}
+
+uint16_t floatToHalf(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    x &= 0x7FFFFFFF;
+    if (x > 0x7F800000)
+        return sign | 0x7E00; // NaN
+    if (x >= 0x477FF000)
+        return sign | 0x7C00; //  65504   - 
+    if (x < 0x38800000)
+    {
+        //  half:    - 2^-24 (1024   )
+        float value;
+        std::memcpy(&value, &x, sizeof(value));
+        return sign | (uint16_t)std::lround(value * 16777216.0f);
+    }
+    //        
+    x += (uint32_t)(15 - 127) << 23;
+    x += 0xFFF + ((x >> 13) & 1);
+    return sign | (uint16_t)(x >> 13);
+}
+
+uint8_t toUnorm8(float value)
+{
+    return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+//  565   16    RGB [0, 1]
+void unpack565(__m128i c, __m128& r, __m128& g, __m128& b)
+{
+    r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c, 11)), _mm_set1_ps(1.0f / 31.0f));
+    g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(63))), _mm_set1_ps(1.0f / 63.0f));
+    b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(c, _mm_set1_epi32(31))), _mm_set1_ps(1.0f / 31.0f));
+}
+
+uint16_t pack565(float r, float g, float b)
+{
+    int r5 = (int)(std::clamp(r, 0.0f, 1.0f) * 31.0f + 0.5f);
+    int g6 = (int)(std::clamp(g, 0.0f, 1.0f) * 63.0f + 0.5f);
+    int b5 = (int)(std::clamp(b, 0.0f, 1.0f) * 31.0f + 0.5f);
+    return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+}
+
+//      2-  BC1 ( ):
+// [0] -   (color0 > color1    BC3), [1] -     
+const float BC1_WEIGHTS[2][4] = {{0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f}, {0.0f, 1.0f, 0.5f, 0.0f}};
+
+__m128 selectIf(__m128i mask, __m128 a, __m128 b)
+{
+    return _mm_blendv_ps(b, a, _mm_castsi128_ps(mask));
+}
+
+//    BC1   :      
+//  ,        color0 + (color1 - color0) * w
+void decodeBC1Color4(const uint8_t* const blocks[4], const int texel[4], bool alwaysFourColors, __m128 rgba[4])
+{
+    __m128i endpoints = _mm_setr_epi32((int)loadU32(blocks[0]), (int)loadU32(blocks[1]), (int)loadU32(blocks[2]),
+                                       (int)loadU32(blocks[3]));
+    __m128i index = _mm_setr_epi32((int)(loadU32(blocks[0] + 4) >> (texel[0] * 2)),
+                                   (int)(loadU32(blocks[1] + 4) >> (texel[1] * 2)),
+                                   (int)(loadU32(blocks[2] + 4) >> (texel[2] * 2)),
+                                   (int)(loadU32(blocks[3] + 4) >> (texel[3] * 2)));
+    index = _mm_and_si128(index, _mm_set1_epi32(3));
+    __m128i c0 = _mm_and_si128(endpoints, _mm_set1_epi32(0xFFFF)), c1 = _mm_srli_epi32(endpoints, 16);
+
+    //  1 - color1, 2  3 - ;  color0 <= color1 ( BC3)  -  
+    __m128i fourColors = alwaysFourColors ? _mm_set1_epi32(-1) : _mm_cmpgt_epi32(c0, c1);
+    __m128i is1 = _mm_cmpeq_epi32(index, _mm_set1_epi32(1));
+    __m128i is2 = _mm_cmpeq_epi32(index, _mm_set1_epi32(2));
+    __m128i is3 = _mm_cmpeq_epi32(index, _mm_set1_epi32(3));
+    __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    __m128 w = _mm_and_ps(_mm_castsi128_ps(is1), one);
+    w = selectIf(is2, selectIf(fourColors, _mm_set1_ps(1.0f / 3.0f), _mm_set1_ps(0.5f)), w);
+    w = selectIf(is3, _mm_set1_ps(2.0f / 3.0f), w);
+    __m128 keep = selectIf(_mm_andnot_si128(fourColors, is3), zero, one);
+
+    __m128 r0, g0, b0, r1, g1, b1;
+    unpack565(c0, r0, g0, b0);
+    unpack565(c1, r1, g1, b1);
+    rgba[0] = _mm_mul_ps(_mm_add_ps(r0, _mm_mul_ps(_mm_sub_ps(r1, r0), w)), keep);
+    rgba[1] = _mm_mul_ps(_mm_add_ps(g0, _mm_mul_ps(_mm_sub_ps(g1, g0), w)), keep);
+    rgba[2] = _mm_mul_ps(_mm_add_ps(b0, _mm_mul_ps(_mm_sub_ps(b1, b0), w)), keep);
+    rgba[3] = keep;
+}
+
+//  BC3:  alpha0 > alpha1  2..7 -   ,
+//  2..5 -  , 6 - , 7 - 
+__m128 decodeBC3Alpha4(const uint8_t* const blocks[4], const int texel[4])
+{
+    uint64_t bits[4] = {loadU64(blocks[0]), loadU64(blocks[1]), loadU64(blocks[2]), loadU64(blocks[3])};
+    __m128i endpoints = _mm_setr_epi32((int)bits[0], (int)bits[1], (int)bits[2], (int)bits[3]);
+    __m128i index = _mm_setr_epi32((int)(bits[0] >> (16 + texel[0] * 3)), (int)(bits[1] >> (16 + texel[1] * 3)),
+                                   (int)(bits[2] >> (16 + texel[2] * 3)), (int)(bits[3] >> (16 + texel[3] * 3)));
+    index = _mm_and_si128(index, _mm_set1_epi32(7));
+    __m128i a0 = _mm_and_si128(endpoints, _mm_set1_epi32(0xFF));
+    __m128i a1 = _mm_and_si128(_mm_srli_epi32(endpoints, 8), _mm_set1_epi32(0xFF));
+    __m128i eight = _mm_cmpgt_epi32(a0, a1);
+
+    __m128 step = selectIf(eight, _mm_set1_ps(1.0f / 7.0f), _mm_set1_ps(1.0f / 5.0f));
+    __m128 w = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(index, _mm_set1_epi32(1))), step);
+    w = selectIf(_mm_cmpeq_epi32(index, _mm_set1_epi32(1)), _mm_set1_ps(1.0f), w);
+    w = selectIf(_mm_cmpeq_epi32(index, _mm_setzero_si128()), _mm_setzero_ps(), w);
+    __m128 alpha0 = _mm_cvtepi32_ps(a0), alpha1 = _mm_cvtepi32_ps(a1);
+    __m128 alpha = _mm_mul_ps(_mm_add_ps(alpha0, _mm_mul_ps(_mm_sub_ps(alpha1, alpha0), w)), _mm_set1_ps(INV_255));
+    __m128i six = _mm_andnot_si128(eight, _mm_cmpgt_epi32(index, _mm_set1_epi32(5)));
+    __m128 constant = _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(7))), _mm_set1_ps(1.0f));
+    return selectIf(six, constant, alpha);
+}
+
+//   4x4  BC1:   -   ,   1/16
+// (   real-time ),  -   .
+// punchThrough -     0.5   (  )
+void encodeBC1Block(const float4 texels[16], bool punchThrough, bool alwaysFourColors, uint8_t out[8])
+{
+    bool transparent[16];
+    bool anyTransparent = false;
+    float lo[3] = {1.0f, 1.0f, 1.0f}, hi[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; ++i)
+    {
+        transparent[i] = punchThrough && texels[i].w < 0.5f;
+        anyTransparent |= transparent[i];
+        if (transparent[i])
+            continue;
+        float c[3] = {texels[i].x, texels[i].y, texels[i].z};
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            lo[ch] = std::min(lo[ch], std::clamp(c[ch], 0.0f, 1.0f));
+            hi[ch] = std::max(hi[ch], std::clamp(c[ch], 0.0f, 1.0f));
+        }
+    }
+    for (int ch = 0; ch < 3; ++ch)
+    {
+        float inset = std::max(hi[ch] - lo[ch], 0.0f) / 16.0f;
+        lo[ch] += inset;
+        hi[ch] -= inset;
+    }
+    uint16_t color0 = pack565(hi[0], hi[1], hi[2]), color1 = pack565(lo[0], lo[1], lo[2]);
+    //     
+    bool threeColors = anyTransparent && !alwaysFourColors;
+    if (threeColors ? color0 > color1 : color0 < color1)
+        std::swap(color0, color1);
+
+    float palette[4][3];
+    int mode = (!alwaysFourColors && color0 <= color1) ? 1 : 0;
+    int paletteSize = mode == 1 ? 3 : 4;
+    for (int ch = 0; ch < 3; ++ch)
+    {
+        static const int SHIFT[3] = {11, 5, 0};
+        static const int MAX[3] = {31, 63, 31};
+        float c0 = (float)((color0 >> SHIFT[ch]) & MAX[ch]) / MAX[ch];
+        float c1 = (float)((color1 >> SHIFT[ch]) & MAX[ch]) / MAX[ch];
+        for (int k = 0; k < paletteSize; ++k)
+            palette[k][ch] = c0 + (c1 - c0) * BC1_WEIGHTS[mode][k];
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t best = 3;
+        if (!transparent[i])
+        {
+            float bestError = FLT_MAX;
+            for (int k = 0; k < paletteSize; ++k)
+            {
+                float dr = texels[i].x - palette[k][0], dg = texels[i].y - palette[k][1], db = texels[i].z - palette[k][2];
+                float error = dr * dr + dg * dg + db * db;
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = (uint32_t)k;
+                }
+            }
+        }
+        indices |= best << (i * 2);
+    }
+    std::memcpy(out, &color0, 2);
+    std::memcpy(out + 2, &color1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// - BC3: alpha0 - , alpha1 -  (  )
+void encodeBC3AlphaBlock(const float4 texels[16], uint8_t out[8])
+{
+    int lo = 255, hi = 0;
+    int alpha[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        alpha[i] = toUnorm8(texels[i].w);
+        lo = std::min(lo, alpha[i]);
+        hi = std::max(hi, alpha[i]);
+    }
+    uint64_t bits = (uint64_t)hi | ((uint64_t)lo << 8);
+    for (int i = 0; i < 16 && hi > lo; ++i)
+    {
+        //   alpha0 (0)  alpha1 (7);  0 - alpha0, 1 - alpha1, 2..7 - 
+        int step = (int)((float)(hi - alpha[i]) * 7.0f / (float)(hi - lo) + 0.5f);
+        uint64_t index = step == 0 ? 0 : (step == 7 ? 1 : (uint64_t)step + 1);
+        bits |= index << (16 + i * 3);
+    }
+    std::memcpy(out, &bits, 8);
+}
+
+int blockSize(TextureFormat format)
+{
+    return format == TextureFormat::BC1 ? 8 : 16;
+}
+
+bool isBlockCompressed(TextureFormat format)
+{
+    return format == TextureFormat::BC1 || format == TextureFormat::BC3;
+}
+//  0  SoA
+float4 firstLane(const __m128 rgba[4])
+{
+    return float4(_mm_cvtss_f32(rgba[0]), _mm_cvtss_f32(rgba[1]), _mm_cvtss_f32(rgba[2]), _mm_cvtss_f32(rgba[3]));
+}
+} // namespace
+
+void TextureRGBA32F::generate_mips(MipFilter filter, ThreadPool* pool)
+{
+    //  :       
+    m_levels.resize(1);
+    size_t total = level_size(m_width, m_height, m_layout);
+    while (m_levels.back().Width > 1 || m_levels.back().Height > 1)
+    {
+        const MipLevel& prev = m_levels.back();
+        MipLevel next = {std::max(prev.Width / 2, 1), std::max(prev.Height / 2, 1), total};
+        total += level_size(next.Width, next.Height, m_layout);
+        m_levels.push_back(next);
+    }
+    m_pixels.resize(total);
+
+    float weights[KAISER_TAPS];
+    __m128 kernel[KAISER_TAPS];
+    std::vector<__m128> temp;
+    if (filter == MipFilter::Kaiser)
+    {
+        kaiserWeights(weights);
+        for (int i = 0; i < KAISER_TAPS; ++i)
+            kernel[i] = _mm_set1_ps(weights[i]);
+    }
+
+    //     :   ,   - .
+    //       (  /  )
+    for (size_t level = 1; level < m_levels.size(); ++level)
+    {
+        const MipLevel src = m_levels[level - 1];
+        const MipLevel dst = m_levels[level];
+        __m128* pixels = m_pixels.data();
+
+        if (filter == MipFilter::Box)
+        {
+            __m128 quarter = _mm_set1_ps(0.25f);
+            parallelRows(pool, dst.Height, [&](int begin, int end) {
+                for (int y = begin; y < end; ++y)
+                {
+                    int y0 = std::min(y * 2, src.Height - 1), y1 = std::min(y * 2 + 1, src.Height - 1);
+                    for (int x = 0; x < dst.Width; ++x)
+                    {
+                        int x0 = std::min(x * 2, src.Width - 1), x1 = std::min(x * 2 + 1, src.Width - 1);
+                        __m128 sum = _mm_add_ps(_mm_add_ps(pixels[texel_index(src, x0, y0)], pixels[texel_index(src, x1, y0)]),
+                                                _mm_add_ps(pixels[texel_index(src, x0, y1)], pixels[texel_index(src, x1, y1)]));
+                        pixels[texel_index(dst, x, y)] = _mm_mul_ps(sum, quarter);
+                    }
+                }
+            });
+            continue;
+        }
+
+        //  :  x    dst.Width x src.Height,   y
+        temp.resize((size_t)dst.Width * src.Height);
+        parallelRows(pool, src.Height, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y)
+            {
+                __m128* out = temp.data() + (size_t)y * dst.Width;
+                for (int x = 0; x < dst.Width; ++x)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (int i = 0; i < KAISER_TAPS; ++i)
+                    {
+                        int sx = std::clamp(x * 2 - KAISER_TAPS / 2 + 1 + i, 0, src.Width - 1);
+                        sum = _mm_add_ps(sum, _mm_mul_ps(pixels[texel_index(src, sx, y)], kernel[i]));
+                    }
+                    out[x] = sum;
+                }
+            }
+        });
+        parallelRows(pool, dst.Height, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y)
+            {
+                const __m128* rows[KAISER_TAPS];
+                for (int i = 0; i < KAISER_TAPS; ++i)
+                    rows[i] = temp.data() + (size_t)std::clamp(y * 2 - KAISER_TAPS / 2 + 1 + i, 0, src.Height - 1) * dst.Width;
+                for (int x = 0; x < dst.Width; ++x)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (int i = 0; i < KAISER_TAPS; ++i)
+                        sum = _mm_add_ps(sum, _mm_mul_ps(rows[i][x], kernel[i]));
+                    pixels[texel_index(dst, x, y)] = sum;
+                }
+            }
+        });
+    }
+}
+
+float TextureRGBA32F::calc_lod(float2 ddx, float2 ddy) const
+{
+    float dxu = ddx.x * m_width, dxv = ddx.y * m_height;
+    float dyu = ddy.x * m_width, dyv = ddy.y * m_height;
+    float rho2 = std::max(dxu * dxu + dxv * dxv, dyu * dyu + dyv * dyv);
+    return 0.5f * std::log2(rho2);
+}
+
+__m128 TextureRGBA32F::sample_bilinear(const MipLevel& level, float2 uv) const
+{
+    //     ( NaN)     
+    float fu = std::clamp(uv.x * level.Width - 0.5f, -1.0f, (float)level.Width);
+    float fv = std::clamp(uv.y * level.Height - 0.5f, -1.0f, (float)level.Height);
+    if (!(fu == fu)) fu = 0.0f;
+    if (!(fv == fv)) fv = 0.0f;
+    float x0f = std::floor(fu), y0f = std::floor(fv);
+    __m128 tx = _mm_set1_ps(fu - x0f), ty = _mm_set1_ps(fv - y0f);
+
+    int x0 = (int)x0f, y0 = (int)y0f;
+    int x1 = std::clamp(x0 + 1, 0, level.Width - 1), y1 = std::clamp(y0 + 1, 0, level.Height - 1);
+    x0 = std::clamp(x0, 0, level.Width - 1);
+    y0 = std::clamp(y0, 0, level.Height - 1);
+
+    __m128 t00 = m_pixels[texel_index(level, x0, y0)], t10 = m_pixels[texel_index(level, x1, y0)];
+    __m128 t01 = m_pixels[texel_index(level, x0, y1)], t11 = m_pixels[texel_index(level, x1, y1)];
+    __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), tx));
+    __m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), tx));
+    return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), ty));
+}
+
+void TextureRGBA32F::sample4(__m128 u, __m128 v, TextureAddressMode address, __m128 rgba[4], int level) const
+{
+    const MipLevel& mip = m_levels[std::clamp(level, 0, (int)m_levels.size() - 1)];
+    const __m128* pixels = m_pixels.data() + mip.Offset;
+    if (m_layout == TextureLayout::Linear)
+    {
+        __m128i stride = _mm_set1_epi32(mip.Width);
+        auto fetch = [pixels, stride](__m128i x, __m128i y, __m128 texels[4]) {
+            gatherTexels(pixels, _mm_add_epi32(_mm_mullo_epi32(y, stride), x), texels);
+        };
+        bilinear4(address, mip.Width, mip.Height, u, v, fetch, rgba);
+        return;
+    }
+
+    __m128i blocksPerRow = _mm_set1_epi32((mip.Width + 3) >> 2);
+    auto fetch = [pixels, blocksPerRow](__m128i x, __m128i y, __m128 texels[4]) {
+        gatherTexels(pixels, tiledIndex(x, y, blocksPerRow), texels);
+    };
+    bilinear4(address, mip.Width, mip.Height, u, v, fetch, rgba);
+}
+
+void TextureRGBA32F::fetch4(int level, __m128i x, __m128i y, __m128 rgba[4]) const
+{
+    const MipLevel& mip = m_levels[level];
+    __m128i index = m_layout == TextureLayout::Linear
+                        ? _mm_add_epi32(_mm_mullo_epi32(y, _mm_set1_epi32(mip.Width)), x)
+                        : tiledIndex(x, y, _mm_set1_epi32((mip.Width + 3) >> 2));
+    gatherTexels(m_pixels.data() + mip.Offset, index, rgba);
+}
+
+void TextureRGBA32F::set_layout(TextureLayout layout)
+{
+    if (layout == m_layout)
+        return;
+
+    std::vector<MipLevel> levels = m_levels;
+    size_t total = 0;
+    for (MipLevel& level : levels)
+    {
+        level.Offset = total;
+        total += level_size(level.Width, level.Height, layout);
+    }
+    std::vector<__m128> pixels(total, _mm_setzero_ps());
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        for (int y = 0; y < levels[i].Height; ++y)
+            for (int x = 0; x < levels[i].Width; ++x)
+                pixels[texel_index(levels[i], x, y, layout)] = m_pixels[texel_index(m_levels[i], x, y)];
+    }
+    m_pixels.swap(pixels);
+    m_levels.swap(levels);
+    m_layout = layout;
+}
+
+void TextureRGBA32F::sample4_grad(__m128 u, __m128 v, float2 ddx, float2 ddy, TextureAddressMode address,
+                                  __m128 rgba[4]) const
+{
+    float lod = calc_lod(ddx, ddy);
+    int maxLevel = (int)m_levels.size() - 1;
+    if (!(lod > 0.0f) || lod >= (float)maxLevel)
+    {
+        sample4(u, v, address, rgba, lod > 0.0f ? maxLevel : 0);
+        return;
+    }
+
+    int level = (int)lod;
+    __m128 t = _mm_set1_ps(lod - (float)level);
+    __m128 coarse[4];
+    sample4(u, v, address, rgba, level);
+    sample4(u, v, address, coarse, level + 1);
+    for (int ch = 0; ch < 4; ++ch)
+        rgba[ch] = _mm_add_ps(rgba[ch], _mm_mul_ps(_mm_sub_ps(coarse[ch], rgba[ch]), t));
+}
+
+float4 TextureRGBA32F::sample_level(float2 uv, float lod) const
+{
+    int maxLevel = (int)m_levels.size() - 1;
+    //  ( NaN) -  0
+    if (!(lod > 0.0f))
+        return float4(sample_bilinear(m_levels[0], uv));
+    if (lod >= (float)maxLevel)
+        return float4(sample_bilinear(m_levels[maxLevel], uv));
+
+    int level = (int)lod;
+    __m128 t = _mm_set1_ps(lod - (float)level);
+    __m128 fine = sample_bilinear(m_levels[level], uv);
+    __m128 coarse = sample_bilinear(m_levels[level + 1], uv);
+    return float4(_mm_add_ps(fine, _mm_mul_ps(_mm_sub_ps(coarse, fine), t)));
+}
+
+TextureCompact::TextureCompact(int2 size, TextureFormat format, int mipCount)
+    : m_width(size.x), m_height(size.y), m_format(format)
+{
+    allocate(mipCount);
+}
+
+TextureCompact::TextureCompact(const TextureRGBA32F& source, TextureFormat format)
+    : m_width(source.width()), m_height(source.height()), m_format(format)
+{
+    allocate(source.mip_count());
+    for (int level = 0; level < mip_count(); ++level)
+    {
+        const MipLevel& mip = m_levels[level];
+        uint8_t* base = data(level);
+        if (isBlockCompressed(format))
+        {
+            //       
+            for (int by = 0; by < (mip.Height + 3) / 4; ++by)
+            {
+                for (int bx = 0; bx < (mip.Width + 3) / 4; ++bx)
+                {
+                    float4 texels[16];
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        int x = std::min(bx * 4 + (i & 3), mip.Width - 1), y = std::min(by * 4 + (i >> 2), mip.Height - 1);
+                        texels[i] = float4(source.read(level, int2(x, y)));
+                    }
+                    uint8_t* block = base + by * mip.Pitch + bx * blockSize(format);
+                    if (format == TextureFormat::BC1)
+                    {
+                        encodeBC1Block(texels, true, false, block);
+                    }
+                    else
+                    {
+                        encodeBC3AlphaBlock(texels, block);
+                        encodeBC1Block(texels, false, true, block + 8);
+                    }
+                }
+            }
+            continue;
+        }
+
+        for (int y = 0; y < mip.Height; ++y)
+        {
+            uint8_t* row = base + y * mip.Pitch;
+            for (int x = 0; x < mip.Width; ++x)
+            {
+                float4 c(source.read(level, int2(x, y)));
+                switch (format)
+                {
+                case TextureFormat::RGBA8:
+                    row[x * 4 + 0] = toUnorm8(c.x);
+                    row[x * 4 + 1] = toUnorm8(c.y);
+                    row[x * 4 + 2] = toUnorm8(c.z);
+                    row[x * 4 + 3] = toUnorm8(c.w);
+                    break;
+                case TextureFormat::R8:
+                    row[x] = toUnorm8(c.x);
+                    break;
+                case TextureFormat::RG16F:
+                {
+                    uint16_t rg[2] = {floatToHalf(c.x), floatToHalf(c.y)};
+                    std::memcpy(row + x * 4, rg, sizeof(rg));
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void TextureCompact::allocate(int mipCount)
+{
+    m_levels.clear();
+    size_t total = 0;
+    int width = m_width, height = m_height;
+    for (int level = 0; mipCount <= 0 || level < mipCount; ++level)
+    {
+        MipLevel mip = {width, height, total, 0};
+        int rows = height;
+        switch (m_format)
+        {
+        case TextureFormat::R8:
+            mip.Pitch = (size_t)width;
+            break;
+        case TextureFormat::BC1:
+        case TextureFormat::BC3:
+            mip.Pitch = (size_t)((width + 3) / 4) * blockSize(m_format);
+            rows = (height + 3) / 4;
+            break;
+        default:
+            mip.Pitch = (size_t)width * 4;
+            break;
+        }
+        total += mip.Pitch * rows;
+        m_levels.push_back(mip);
+        if (width == 1 && height == 1)
+            break;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    m_data.assign(total, 0);
+}
+
+void TextureCompact::fetch4(const MipLevel& level, __m128i x, __m128i y, __m128 rgba[4]) const
+{
+    alignas(16) int32_t xs[4], ys[4];
+    _mm_store_si128((__m128i*)xs, x);
+    _mm_store_si128((__m128i*)ys, y);
+    const uint8_t* base = m_data.data() + level.Offset;
+
+    if (isBlockCompressed(m_format))
+    {
+        int size = blockSize(m_format);
+        const uint8_t* blocks[4];
+        int texel[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            blocks[i] = base + (size_t)(ys[i] >> 2) * level.Pitch + (size_t)(xs[i] >> 2) * size;
+            texel[i] = (ys[i] & 3) * 4 + (xs[i] & 3);
+        }
+        if (m_format == TextureFormat::BC1)
+        {
+            decodeBC1Color4(blocks, texel, false, rgba);
+            return;
+        }
+        const uint8_t* colorBlocks[4] = {blocks[0] + 8, blocks[1] + 8, blocks[2] + 8, blocks[3] + 8};
+        decodeBC1Color4(colorBlocks, texel, true, rgba);
+        rgba[3] = decodeBC3Alpha4(blocks, texel);
+        return;
+    }
+
+    if (m_format == TextureFormat::R8)
+    {
+        __m128i r = _mm_setr_epi32(base[ys[0] * level.Pitch + xs[0]], base[ys[1] * level.Pitch + xs[1]],
+                                   base[ys[2] * level.Pitch + xs[2]], base[ys[3] * level.Pitch + xs[3]]);
+        rgba[0] = _mm_mul_ps(_mm_cvtepi32_ps(r), _mm_set1_ps(INV_255));
+        rgba[1] = _mm_setzero_ps();
+        rgba[2] = _mm_setzero_ps();
+        rgba[3] = _mm_set1_ps(1.0f);
+        return;
+    }
+
+    // RGBA8  RG16F:  4   ,    
+    __m128i p = _mm_setr_epi32((int)loadU32(base + ys[0] * level.Pitch + xs[0] * 4),
+                               (int)loadU32(base + ys[1] * level.Pitch + xs[1] * 4),
+                               (int)loadU32(base + ys[2] * level.Pitch + xs[2] * 4),
+                               (int)loadU32(base + ys[3] * level.Pitch + xs[3] * 4));
+    if (m_format == TextureFormat::RG16F)
+    {
+        rgba[0] = halfToFloat4(p);
+        rgba[1] = halfToFloat4(_mm_srli_epi32(p, 16));
+        rgba[2] = _mm_setzero_ps();
+        rgba[3] = _mm_set1_ps(1.0f);
+        return;
+    }
+    __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128 scale = _mm_set1_ps(INV_255);
+    rgba[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, byteMask)), scale);
+    rgba[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), byteMask)), scale);
+    rgba[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), byteMask)), scale);
+    rgba[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 24)), scale);
+}
+
+float4 TextureCompact::read(int level, int2 coords) const
+{
+    const MipLevel& mip = m_levels[level];
+    assert(coords.x >= 0 && coords.x < mip.Width && coords.y >= 0 && coords.y < mip.Height);
+    __m128 rgba[4];
+    fetch4(mip, _mm_set1_epi32(coords.x), _mm_set1_epi32(coords.y), rgba);
+    return firstLane(rgba);
+}
+
+float TextureCompact::calc_lod(float2 ddx, float2 ddy) const
+{
+    float dxu = ddx.x * m_width, dxv = ddx.y * m_height;
+    float dyu = ddy.x * m_width, dyv = ddy.y * m_height;
+    float rho2 = std::max(dxu * dxu + dxv * dxv, dyu * dyu + dyv * dyv);
+    return 0.5f * std::log2(rho2);
+}
+
+void TextureCompact::sample4(__m128 u, __m128 v, TextureAddressMode address, __m128 rgba[4], int level) const
+{
+    const MipLevel& mip = m_levels[std::clamp(level, 0, (int)m_levels.size() - 1)];
+    auto fetch = [this, &mip](__m128i x, __m128i y, __m128 texels[4]) { fetch4(mip, x, y, texels); };
+    bilinear4(address, mip.Width, mip.Height, u, v, fetch, rgba);
+}
+
+void TextureCompact::sample4_lod(__m128 u, __m128 v, float lod, TextureAddressMode address, __m128 rgba[4]) const
+{
+    int maxLevel = (int)m_levels.size() - 1;
+    if (!(lod > 0.0f) || lod >= (float)maxLevel)
+    {
+        sample4(u, v, address, rgba, lod > 0.0f ? maxLevel : 0);
+        return;
+    }
+
+    int level = (int)lod;
+    __m128 t = _mm_set1_ps(lod - (float)level);
+    __m128 coarse[4];
+    sample4(u, v, address, rgba, level);
+    sample4(u, v, address, coarse, level + 1);
+    for (int ch = 0; ch < 4; ++ch)
+        rgba[ch] = _mm_add_ps(rgba[ch], _mm_mul_ps(_mm_sub_ps(coarse[ch], rgba[ch]), t));
+}
+
+void TextureCompact::sample4_grad(__m128 u, __m128 v, float2 ddx, float2 ddy, TextureAddressMode address,
+                                  __m128 rgba[4]) const
+{
+    sample4_lod(u, v, calc_lod(ddx, ddy), address, rgba);
+}
+
+float4 TextureCompact::sample_level(float2 uv, float lod) const
+{
+    //     0 (      )
+    __m128 rgba[4];
+    sample4_lod(_mm_set1_ps(uv.x), _mm_set1_ps(uv.y), lod, TextureAddressMode::Clamp, rgba);
+    return firstLane(rgba);
+}
+
+namespace
+{
+//      ,    .
+// lod      
+template <class Texture, TextureFilter Filter, TextureAddressMode AddressU, TextureAddressMode AddressV>
+void samplerSample4(const Texture& texture, __m128 u, __m128 v, float lod, __m128 border, __m128 rgba[4])
+{
+    auto sampleLevel = [&](int level, __m128 out[4]) {
+        int2 size = texture.mip_size(level);
+        auto fetch = [&texture, level](__m128i x, __m128i y, __m128 texels[4]) { texture.fetch4(level, x, y, texels); };
+        if (Filter == TextureFilter::Point)
+            point4<AddressU, AddressV>(size.x, size.y, u, v, fetch, border, out);
+        else
+            bilinear4<AddressU, AddressV>(size.x, size.y, u, v, fetch, border, out);
+    };
+
+    //  ( NaN) -  0
+    int maxLevel = texture.mip_count() - 1;
+    lod = lod > 0.0f ? std::min(lod, (float)maxLevel) : 0.0f;
+    if (Filter != TextureFilter::Trilinear)
+    {
+        sampleLevel((int)(lod + 0.5f), rgba);
+        return;
+    }
+
+    int level = (int)lod;
+    sampleLevel(level, rgba);
+    if (level == maxLevel || lod == (float)level)
+        return;
+    __m128 t = _mm_set1_ps(lod - (float)level);
+    __m128 coarse[4];
+    sampleLevel(level + 1, coarse);
+    for (int ch = 0; ch < 4; ++ch)
+        rgba[ch] = _mm_add_ps(rgba[ch], _mm_mul_ps(_mm_sub_ps(coarse[ch], rgba[ch]), t));
+}
+
+template <class Texture> using SamplerFunction = void (*)(const Texture&, __m128, __m128, float, __m128, __m128*);
+
+template <class Texture, TextureFilter Filter, TextureAddressMode AddressU>
+SamplerFunction<Texture> selectSampler(TextureAddressMode addressV)
+{
+    switch (addressV)
+    {
+    case TextureAddressMode::Wrap:
+        return &samplerSample4<Texture, Filter, AddressU, TextureAddressMode::Wrap>;
+    case TextureAddressMode::Mirror:
+        return &samplerSample4<Texture, Filter, AddressU, TextureAddressMode::Mirror>;
+    case TextureAddressMode::Border:
+        return &samplerSample4<Texture, Filter, AddressU, TextureAddressMode::Border>;
+    default:
+        return &samplerSample4<Texture, Filter, AddressU, TextureAddressMode::Clamp>;
+    }
+}
+
+template <class Texture, TextureFilter Filter>
+SamplerFunction<Texture> selectSampler(TextureAddressMode addressU, TextureAddressMode addressV)
+{
+    switch (addressU)
+    {
+    case TextureAddressMode::Wrap:
+        return selectSampler<Texture, Filter, TextureAddressMode::Wrap>(addressV);
+    case TextureAddressMode::Mirror:
+        return selectSampler<Texture, Filter, TextureAddressMode::Mirror>(addressV);
+    case TextureAddressMode::Border:
+        return selectSampler<Texture, Filter, TextureAddressMode::Border>(addressV);
+    default:
+        return selectSampler<Texture, Filter, TextureAddressMode::Clamp>(addressV);
+    }
+}
+
+template <class Texture> SamplerFunction<Texture> selectSampler(const SamplerDesc& desc)
+{
+    switch (desc.Filter)
+    {
+    case TextureFilter::Point:
+        return selectSampler<Texture, TextureFilter::Point>(desc.AddressU, desc.AddressV);
+    case TextureFilter::Bilinear:
+        return selectSampler<Texture, TextureFilter::Bilinear>(desc.AddressU, desc.AddressV);
+    default:
+        return selectSampler<Texture, TextureFilter::Trilinear>(desc.AddressU, desc.AddressV);
+    }
+}
+} // namespace
+
+SamplerState::SamplerState(const SamplerDesc& desc)
+    : m_desc(desc), m_sampleRGBA32F(selectSampler<TextureRGBA32F>(desc)),
+      m_sampleCompact(selectSampler<TextureCompact>(desc))
+{
+}
+
+float SamplerState::clamp_lod(float lod) const
+{
+    lod += m_desc.MipLodBias;
+    // NaN -   (   -inf    MinLod)
+    if (!(lod == lod))
+        lod = 0.0f;
+    return std::clamp(lod, m_desc.MinLod, m_desc.MaxLod);
+}
+
+void SamplerState::sample4(const TextureRGBA32F& texture, __m128 u, __m128 v, float2 ddx, float2 ddy,
+                           __m128 rgba[4]) const
+{
+    m_sampleRGBA32F(texture, u, v, clamp_lod(texture.calc_lod(ddx, ddy)), m_desc.BorderColor.v, rgba);
+}
+
+void SamplerState::sample4(const TextureCompact& texture, __m128 u, __m128 v, float2 ddx, float2 ddy,
+                           __m128 rgba[4]) const
+{
+    m_sampleCompact(texture, u, v, clamp_lod(texture.calc_lod(ddx, ddy)), m_desc.BorderColor.v, rgba);
+}
+
+void SamplerState::sample4_level(const TextureRGBA32F& texture, __m128 u, __m128 v, float lod, __m128 rgba[4]) const
+{
+    m_sampleRGBA32F(texture, u, v, clamp_lod(lod), m_desc.BorderColor.v, rgba);
+}
+
+void SamplerState::sample4_level(const TextureCompact& texture, __m128 u, __m128 v, float lod, __m128 rgba[4]) const
+{
+    m_sampleCompact(texture, u, v, clamp_lod(lod), m_desc.BorderColor.v, rgba);
+}
+
+float4 SamplerState::sample(const TextureRGBA32F& texture, float2 uv, float2 ddx, float2 ddy) const
+{
+    __m128 rgba[4];
+    sample4(texture, _mm_set1_ps(uv.x), _mm_set1_ps(uv.y), ddx, ddy, rgba);
+    return firstLane(rgba);
+}
+
+float4 SamplerState::sample(const TextureCompact& texture, float2 uv, float2 ddx, float2 ddy) const
+{
+    __m128 rgba[4];
+    sample4(texture, _mm_set1_ps(uv.x), _mm_set1_ps(uv.y), ddx, ddy, rgba);
+    return firstLane(rgba);
+}
+
+SOFTX_END
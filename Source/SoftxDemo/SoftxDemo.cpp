@@ -1,6 +1,11 @@
 ﻿#define SOFTX_STATIC
 #include <Windows.h>
 #include <SoftX/SoftX.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
 
 #pragma comment(lib, "SoftX.lib")
 
@@ -97,8 +102,171 @@ void CreateCube(VertexBuffer& vb, IndexBuffer& ib)
 	}
 }
 
-int main()
+// ========== Бенчмарк оптимизатора мешей (SoftxDemo.exe --meshopt-bench) ==========
+
+// Счётчики вызовов шейдеров (тайлы рендерятся в нескольких потоках)
+std::atomic<uint32_t> g_vsInvocations(0);
+std::atomic<uint32_t> g_psInvocations(0);
+
+VertexOutput vsCounting(const VertexInput& in, ConstantBuffer cb)
+{
+	g_vsInvocations.fetch_add(1, std::memory_order_relaxed);
+	return vsTransform(in, cb);
+}
+
+float4 psCounting(const VertexOutput& in, ConstantBuffer cb)
+{
+	g_psInvocations.fetch_add(1, std::memory_order_relaxed);
+	return psColor(in, cb);
+}
+
+// Решётка 4x4x4 сфер, треугольники и вершины перемешаны - как меш, пришедший в произвольном порядке
+void CreateSphereCluster(VertexBuffer& vb, IndexBuffer& ib)
+{
+	const int rings = 24, segments = 48;
+	std::vector<VertexInput> vertices;
+	std::vector<uint32_t> indices;
+
+	for (int sx = 0; sx < 4; ++sx)
+		for (int sy = 0; sy < 4; ++sy)
+			for (int sz = 0; sz < 4; ++sz)
+			{
+				float3 center((sx - 1.5f) * 2.5f, (sy - 1.5f) * 2.5f, (sz - 1.5f) * 2.5f);
+				float4 color(sx / 3.0f, sy / 3.0f, sz / 3.0f, 1.0f);
+				uint32_t base = (uint32_t)vertices.size();
+
+				for (int r = 0; r <= rings; ++r)
+				{
+					float theta = 3.14159265f * r / rings;
+					for (int s = 0; s <= segments; ++s)
+					{
+						float phi = 2.0f * 3.14159265f * s / segments;
+						float3 n(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+						vertices.push_back({float3(center.x + n.x, center.y + n.y, center.z + n.z), color,
+											float2(float(s) / segments, float(r) / rings)});
+					}
+				}
+
+				for (int r = 0; r < rings; ++r)
+					for (int s = 0; s < segments; ++s)
+					{
+						uint32_t i0 = base + r * (segments + 1) + s;
+						uint32_t i1 = i0 + 1;
+						uint32_t i2 = i0 + segments + 1;
+						uint32_t i3 = i2 + 1;
+						// Обход по часовой стрелке, если смотреть снаружи
+						indices.insert(indices.end(), {i0, i1, i2, i1, i3, i2});
+					}
+			}
+
+	// Перемешиваем треугольники и нумерацию вершин
+	std::mt19937 rng(1);
+	size_t triCount = indices.size() / 3;
+	for (size_t t = triCount - 1; t > 0; --t)
+	{
+		size_t j = rng() % (t + 1);
+		for (int k = 0; k < 3; ++k)
+			std::swap(indices[t * 3 + k], indices[j * 3 + k]);
+	}
+	std::vector<uint32_t> permutation(vertices.size());
+	for (uint32_t i = 0; i < permutation.size(); ++i)
+		permutation[i] = i;
+	std::shuffle(permutation.begin(), permutation.end(), rng);
+
+	std::vector<VertexInput> shuffled(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+		shuffled[permutation[i]] = vertices[i];
+	for (uint32_t& index : indices)
+		index = permutation[index];
+
+	vb = VertexBuffer(shuffled);
+	ib = IndexBuffer(indices);
+}
+
+// Оценки оптимизатора и реальные вызовы шейдеров SoftX (8 ракурсов, средние на кадр)
+void MeasureMesh(Device& device, const char* label, const VertexBuffer& vb, const IndexBuffer& ib)
 {
+	const float* positions = reinterpret_cast<const float*>(vb.Data() + offsetof(VertexInput, Position));
+	VertexCacheStats cache = AnalyzeVertexCache(ib.Data(), ib.Size(), vb.Size());
+	OverdrawStats overdraw = AnalyzeOverdraw(ib.Data(), ib.Size(), positions, vb.Size(), vb.Stride());
+	VertexFetchStats fetch = AnalyzeVertexFetch(ib.Data(), ib.Size(), vb.Size(), vb.Stride());
+
+	DeviceContext ctx = device.GetDeviceContext();
+	ctx.SetVertexBuffer(vb);
+	ctx.SetIndexBuffer(ib);
+	device.SetDeviceContext(ctx);
+
+	const int views = 8;
+	float4x4 view = lookAtLH(float3(0, 0, -25), float3(0, 0, 0), float3(0, 1, 0));
+	float4x4 proj = perspectiveLH(3.14159f / 4.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+	g_vsInvocations = 0;
+	g_psInvocations = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < views; ++i)
+	{
+		float angle = 6.2831853f * i / views;
+		TransformCB cb;
+		cb.wvp = proj * view * rotationY(angle) * rotationX(angle * 0.3f);
+		device.SetConstantBuffer(device.UploadConstantBuffer(&cb, sizeof(cb)));
+		device.Clear(float4(0.2f, 0.2f, 0.2f, 1.0f));
+		device.ClearDepth(1.0f);
+		device.DrawIndexed();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double ms = std::chrono::duration<double, std::milli>(end - start).count() / views;
+
+	printf("%-16s ACMR %.3f  ATVR %.3f  overdraw %.3f  overfetch %.3f | VS %7u  PS %8u  %.2f ms\n", label, cache.ACMR,
+		   cache.ATVR, overdraw.Overdraw, fetch.Overfetch, g_vsInvocations.load() / views,
+		   g_psInvocations.load() / views, ms);
+}
+
+int RunMeshOptimizerBenchmark()
+{
+	PresentParameters pp;
+	pp.BackBufferSize = int2(800, 600);
+	pp.hDeviceWindow = nullptr;
+	pp.Windowed = true;
+	Device device(pp);
+
+	Viewport vp;
+	vp.size = pp.BackBufferSize;
+
+	DeviceContext ctx;
+	ctx.SetRenderTarget(&device.GetBackBuffer());
+	ctx.SetViewport(vp);
+	ctx.SetVertexShader(vsCounting);
+	ctx.SetPixelShader(psCounting);
+	ctx.SetCullMode(CullMode::Back);
+	ctx.SetFillMode(FillMode::Solid);
+	ctx.SetTileRenderingState(true);
+	ctx.SetTileSize(64);
+	device.SetDeviceContext(ctx);
+
+	VertexBuffer vb;
+	IndexBuffer ib;
+	CreateSphereCluster(vb, ib);
+	printf("%zu vertices, %zu triangles (FIFO cache 16)\n", vb.Size(), ib.Size() / 3);
+	MeasureMesh(device, "unoptimized", vb, ib);
+
+	// Этапы по отдельности, чтобы видеть вклад каждого
+	std::vector<uint32_t> indices(ib.Data(), ib.Data() + ib.Size());
+	OptimizeVertexCache(indices.data(), indices.data(), indices.size(), vb.Size());
+	MeasureMesh(device, "vertex cache", vb, IndexBuffer(indices));
+
+	const float* positions = reinterpret_cast<const float*>(vb.Data() + offsetof(VertexInput, Position));
+	OptimizeOverdraw(indices.data(), indices.data(), indices.size(), positions, vb.Size(), vb.Stride());
+	MeasureMesh(device, "+ overdraw", vb, IndexBuffer(indices));
+
+	OptimizeMesh(vb, ib);
+	MeasureMesh(device, "+ vertex fetch", vb, ib);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--meshopt-bench") == 0)
+		return RunMeshOptimizerBenchmark();
+
 	HINSTANCE hInstance = GetModuleHandle(nullptr);
 
 	// Регистрация класса окна
@@ -187,8 +355,7 @@ int main()
 		float4x4 proj = perspectiveLH(3.14159f / 4.0f, aspect, 0.1f, 100.0f);
 		TransformCB cb;
 		cb.wvp = proj * view * model;
-		ConstantBuffer cbuffer(&cb, sizeof(cb));
-		device.SetConstantBuffer(cbuffer);
+		device.SetConstantBuffer(device.UploadConstantBuffer(&cb, sizeof(cb)));
 
 		// Очистка буферов
 		device.Clear(float4(0.2f, 0.2f, 0.2f, 1.0f));